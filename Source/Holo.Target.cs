@@ -9,6 +9,9 @@ public class HoloTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		// Push model replication is compiled out of the installed engine's shared build environment
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+		bWithPushModel = true;
 
 		ExtraModuleNames.AddRange( new string[] { "Holo" } );
 	}
@@ -0,0 +1,176 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloAssetPreloadSubsystem.h"
+
+#include "Holo.h"
+#include "Core/HoloEffectPoolSubsystem.h"
+#include "Core/HoloGameMode.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Particles/ParticleSystem.h"
+#include "Player/HoloPawn.h"
+#include "ShaderPipelineCache.h"
+#include "Weapons/HoloWeapon.h"
+
+bool UHoloAssetPreloadSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UHoloAssetPreloadSubsystem::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		Handle->CancelHandle();
+	}
+	Handles.Reset();
+
+	if (bPreloading)
+	{
+		bPreloading = false;
+		FShaderPipelineCache::SetBatchMode(FShaderPipelineCache::BatchMode::Background);
+	}
+
+	Super::Deinitialize();
+}
+
+void UHoloAssetPreloadSubsystem::PreloadGameContent(const AHoloGameMode* GameMode)
+{
+	check(GameMode);
+
+	TArray<FSoftObjectPath> Assets = GameMode->GetPreloadAssets();
+
+	const AHoloPawn* Pawn = GameMode->DefaultPawnClass ? Cast<AHoloPawn>(GameMode->DefaultPawnClass->GetDefaultObject()) : nullptr;
+	if (!Pawn)
+	{
+		RequestPreload(Assets);
+		return;
+	}
+
+	const bool bCosmetics = Holo::ShouldPlayCosmetics(this);
+	Pawn->GetPreloadAssets(Assets, bCosmetics);
+
+	// Weapon effects are only known once the weapon class is loaded, and only useful where they can be seen
+	TWeakObjectPtr<const AHoloPawn> WeakPawn = Pawn;
+	RequestPreload(Assets, FSimpleDelegate::CreateWeakLambda(this, [this, WeakPawn, bCosmetics]()
+	{
+		const UClass* WeaponClass = WeakPawn.IsValid() ? WeakPawn->GetDefaultWeaponClass().Get() : nullptr;
+		if (WeaponClass && bCosmetics)
+		{
+			TArray<FSoftObjectPath> WeaponAssets;
+			WeaponClass->GetDefaultObject<AHoloWeapon>()->GetPreloadAssets(WeaponAssets);
+			RequestPreload(WeaponAssets);
+		}
+	}));
+}
+
+void UHoloAssetPreloadSubsystem::RequestPreload(const TArray<FSoftObjectPath>& Assets, FSimpleDelegate OnLoaded)
+{
+	// Assets already in memory were requested before, e.g. by an earlier weapon of the same class: don't track them again
+	TArray<FSoftObjectPath> AssetsToLoad;
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (Asset.IsValid() && !Asset.ResolveObject())
+		{
+			AssetsToLoad.AddUnique(Asset);
+		}
+	}
+
+	if (AssetsToLoad.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	if (!bPreloading)
+	{
+		bPreloading = true;
+		PreloadStartTime = FPlatformTime::Seconds();
+
+		// Compile the pipeline states recorded by previous runs while players are still loading in, rather than on first draw
+		FShaderPipelineCache::SetBatchMode(FShaderPipelineCache::BatchMode::Fast);
+	}
+
+	const FStreamableDelegate LoadedDelegate = FStreamableDelegate::CreateUObject(this, &UHoloAssetPreloadSubsystem::OnRequestLoaded, AssetsToLoad, OnLoaded);
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, LoadedDelegate, FStreamableManager::AsyncLoadHighPriority, false, false, TEXT("HoloPreload"));
+	if (!Handle.IsValid())
+	{
+		// Nothing could be loaded: callers still rely on being called back, e.g. to fall back on what's in memory
+		OnLoaded.ExecuteIfBound();
+		UpdateProgress();
+		return;
+	}
+
+	Handle->BindUpdateDelegate(FStreamableUpdateDelegate::CreateUObject(this, &UHoloAssetPreloadSubsystem::OnRequestUpdated));
+	Handles.Add(Handle);
+}
+
+float UHoloAssetPreloadSubsystem::GetProgress() const
+{
+	int32 NumAssets = 0;
+	float NumLoadedAssets = 0.0f;
+	for (const TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		TArray<FSoftObjectPath> RequestedAssets;
+		Handle->GetRequestedAssets(RequestedAssets);
+		NumAssets += RequestedAssets.Num();
+		NumLoadedAssets += Handle->GetProgress() * RequestedAssets.Num();
+	}
+
+	return NumAssets > 0 ? NumLoadedAssets / NumAssets : 1.0f;
+}
+
+void UHoloAssetPreloadSubsystem::OnRequestLoaded(TArray<FSoftObjectPath> Assets, FSimpleDelegate OnLoaded)
+{
+	PrewarmEffects(Assets);
+
+	// May request more assets, which must be accounted for before deciding whether the preload is over
+	OnLoaded.ExecuteIfBound();
+
+	UpdateProgress();
+}
+
+void UHoloAssetPreloadSubsystem::OnRequestUpdated(TSharedRef<FStreamableHandle> Handle)
+{
+	UpdateProgress();
+}
+
+void UHoloAssetPreloadSubsystem::PrewarmEffects(const TArray<FSoftObjectPath>& Assets) const
+{
+	UHoloEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UHoloEffectPoolSubsystem>();
+	if (!EffectPool || PrewarmedComponentsPerEffect <= 0)
+	{
+		return;
+	}
+
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (UParticleSystem* ParticleSystem = Cast<UParticleSystem>(Asset.ResolveObject()))
+		{
+			EffectPool->PrewarmEmitter(ParticleSystem, PrewarmedComponentsPerEffect);
+		}
+	}
+}
+
+void UHoloAssetPreloadSubsystem::UpdateProgress()
+{
+	if (!bPreloading)
+	{
+		return;
+	}
+
+	const bool bLoaded = !Handles.ContainsByPredicate([](const TSharedPtr<FStreamableHandle>& Handle) { return !Handle->HasLoadCompleted(); });
+	if (!bLoaded)
+	{
+		OnPreloadProgressDelegate.Broadcast(GetProgress());
+		return;
+	}
+
+	UE_LOG(LogHolo, Log, TEXT("Preloaded game content in %.2fs"), FPlatformTime::Seconds() - PreloadStartTime);
+
+	bPreloading = false;
+	FShaderPipelineCache::SetBatchMode(FShaderPipelineCache::BatchMode::Background);
+	OnPreloadProgressDelegate.Broadcast(1.0f);
+}
@@ -0,0 +1,245 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloEffectPoolSubsystem.h"
+
+#include "Holo.h"
+#include "Components/AudioComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Effects Played"), STAT_HoloPooledEffectsPlayed, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Effects Culled"), STAT_HoloPooledEffectsCulled, STATGROUP_Holo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Effect Components"), STAT_HoloPooledEffectComponents, STATGROUP_Holo);
+
+bool UHoloEffectPoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nobody is there to see or hear anything on a dedicated server
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+void UHoloEffectPoolSubsystem::Deinitialize()
+{
+	for (TPair<UParticleSystem*, FHoloParticleEffectPool>& Pair : ParticlePools)
+	{
+		for (UParticleSystemComponent* Component : Pair.Value.Components)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+		DEC_DWORD_STAT_BY(STAT_HoloPooledEffectComponents, Pair.Value.Components.Num());
+	}
+
+	for (TPair<USoundBase*, FHoloAudioEffectPool>& Pair : AudioPools)
+	{
+		for (UAudioComponent* Component : Pair.Value.Components)
+		{
+			if (Component)
+			{
+				Component->DestroyComponent();
+			}
+		}
+		DEC_DWORD_STAT_BY(STAT_HoloPooledEffectComponents, Pair.Value.Components.Num());
+	}
+
+	ParticlePools.Empty();
+	AudioPools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHoloEffectPoolSubsystem::Tick(float DeltaTime)
+{
+	NumEffectsThisFrame = 0;
+
+	// Cull against the view of the first local player, that's the only one there is outside of split screen
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	bHasViewLocation = PC && PC->IsLocalController();
+	if (bHasViewLocation)
+	{
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
+}
+
+TStatId UHoloEffectPoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloEffectPoolSubsystem, STATGROUP_Tickables);
+}
+
+UParticleSystemComponent* UHoloEffectPoolSubsystem::SpawnEmitterAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation)
+{
+	if (!Template || !ConsumeBudget(Location, ParticleCullDistance))
+	{
+		return nullptr;
+	}
+
+	UParticleSystemComponent* Component = AcquireParticleComponent(Template);
+	if (Component->GetAttachParent())
+	{
+		Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->ActivateSystem(true);
+	return Component;
+}
+
+void UHoloEffectPoolSubsystem::SpawnEmitterAttached(UParticleSystem* Template, USceneComponent* AttachToComponent)
+{
+	if (!Template || !AttachToComponent || !ConsumeBudget(AttachToComponent->GetComponentLocation(), ParticleCullDistance))
+	{
+		return;
+	}
+
+	UParticleSystemComponent* Component = AcquireParticleComponent(Template);
+	if (Component->GetAttachParent() != AttachToComponent)
+	{
+		Component->AttachToComponent(AttachToComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	}
+	Component->ActivateSystem(true);
+}
+
+void UHoloEffectPoolSubsystem::PlaySoundAtLocation(USoundBase* Sound, const FVector& Location, const FRotator& Rotation)
+{
+	if (!Sound || !ConsumeBudget(Location, Sound->GetMaxDistance()))
+	{
+		return;
+	}
+
+	UAudioComponent* Component = AcquireAudioComponent(Sound);
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->Play();
+}
+
+void UHoloEffectPoolSubsystem::PrewarmEmitter(UParticleSystem* Template, int32 NumComponents)
+{
+	if (!Template)
+	{
+		return;
+	}
+
+	FHoloParticleEffectPool& Pool = ParticlePools.FindOrAdd(Template);
+	const int32 NumToCreate = FMath::Min(NumComponents, MaxComponentsPerEffect) - Pool.Components.Num();
+	for (int32 Index = 0; Index < NumToCreate; ++Index)
+	{
+		Pool.Components.Add(CreateParticleComponent(Template));
+		Pool.LastUseTimes.Add(0.0f);
+		INC_DWORD_STAT(STAT_HoloPooledEffectComponents);
+	}
+}
+
+bool UHoloEffectPoolSubsystem::ConsumeBudget(const FVector& Location, float CullDistance)
+{
+	const bool bTooFar = bHasViewLocation && FVector::DistSquared(Location, ViewLocation) > FMath::Square(CullDistance);
+	if (bTooFar || NumEffectsThisFrame >= MaxEffectsPerFrame)
+	{
+		HOLO_INC_COUNTER(PooledEffectsCulled, 1);
+		return false;
+	}
+
+	++NumEffectsThisFrame;
+	HOLO_INC_COUNTER(PooledEffectsPlayed, 1);
+	return true;
+}
+
+UParticleSystemComponent* UHoloEffectPoolSubsystem::AcquireParticleComponent(UParticleSystem* Template)
+{
+	FHoloParticleEffectPool& Pool = ParticlePools.FindOrAdd(Template);
+	const int32 Slot = FindPoolSlot<UParticleSystemComponent>(Pool.Components, Pool.LastUseTimes, [](const UParticleSystemComponent* Component)
+	{
+		return Component->IsActive();
+	});
+
+	if (!Pool.Components.IsValidIndex(Slot) || !Pool.Components[Slot])
+	{
+		UParticleSystemComponent* Component = CreateParticleComponent(Template);
+		if (Slot < Pool.Components.Num())
+		{
+			Pool.Components[Slot] = Component;
+		}
+		else
+		{
+			Pool.Components.Add(Component);
+			Pool.LastUseTimes.Add(0.0f);
+			INC_DWORD_STAT(STAT_HoloPooledEffectComponents);
+		}
+	}
+
+	Pool.LastUseTimes[Slot] = GetWorld()->GetTimeSeconds();
+	return Pool.Components[Slot];
+}
+
+UParticleSystemComponent* UHoloEffectPoolSubsystem::CreateParticleComponent(UParticleSystem* Template)
+{
+	// Same setup as UGameplayStatics, minus the auto destroy
+	UWorld* World = GetWorld();
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World->GetWorldSettings());
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowAnyoneToDestroyMe = true;
+	Component->SecondsBeforeInactive = 0.0f;
+	Component->SetTemplate(Template);
+	Component->RegisterComponentWithWorld(World);
+	return Component;
+}
+
+UAudioComponent* UHoloEffectPoolSubsystem::AcquireAudioComponent(USoundBase* Sound)
+{
+	FHoloAudioEffectPool& Pool = AudioPools.FindOrAdd(Sound);
+	const int32 Slot = FindPoolSlot<UAudioComponent>(Pool.Components, Pool.LastUseTimes, [](const UAudioComponent* Component)
+	{
+		return Component->IsPlaying();
+	});
+
+	if (!Pool.Components.IsValidIndex(Slot) || !Pool.Components[Slot])
+	{
+		UWorld* World = GetWorld();
+		UAudioComponent* Component = NewObject<UAudioComponent>(World->GetWorldSettings());
+		Component->bAutoActivate = false;
+		Component->bAutoDestroy = false;
+		Component->bAllowSpatialization = true;
+		Component->SetSound(Sound);
+		Component->RegisterComponentWithWorld(World);
+
+		if (Slot < Pool.Components.Num())
+		{
+			Pool.Components[Slot] = Component;
+		}
+		else
+		{
+			Pool.Components.Add(Component);
+			Pool.LastUseTimes.Add(0.0f);
+			INC_DWORD_STAT(STAT_HoloPooledEffectComponents);
+		}
+	}
+
+	Pool.LastUseTimes[Slot] = GetWorld()->GetTimeSeconds();
+	return Pool.Components[Slot];
+}
+
+template<typename ComponentType>
+int32 UHoloEffectPoolSubsystem::FindPoolSlot(const TArray<ComponentType*>& Components, const TArray<float>& LastUseTimes, TFunctionRef<bool(const ComponentType*)> IsBusy) const
+{
+	int32 OldestSlot = INDEX_NONE;
+	for (int32 Slot = 0; Slot < Components.Num(); ++Slot)
+	{
+		const ComponentType* Component = Components[Slot];
+		if (!Component || !IsBusy(Component))
+		{
+			return Slot;
+		}
+
+		if (OldestSlot == INDEX_NONE || LastUseTimes[Slot] < LastUseTimes[OldestSlot])
+		{
+			OldestSlot = Slot;
+		}
+	}
+
+	// Everything is busy: grow the pool if we still can, otherwise restart the effect that has been playing for the longest time
+	return Components.Num() < MaxComponentsPerEffect || OldestSlot == INDEX_NONE ? Components.Num() : OldestSlot;
+}
@@ -2,10 +2,13 @@
 
 
 #include "Core/HoloGameMode.h"
-#include "GameFramework/PlayerStart.h"
-#include "Kismet/GameplayStatics.h"
+#include "Holo.h"
+#include "Core/HoloGameState.h"
+#include "Core/HoloSpawnSelectionSubsystem.h"
 #include "Player/HoloPawn.h"
 
+DECLARE_CYCLE_STAT(TEXT("Find Player Start"), STAT_HoloFindPlayerStart, STATGROUP_Holo);
+
 AHoloGameMode::AHoloGameMode()
 {
 	// Establish a sequence of arbitrary colors that we'll apply to each player
@@ -16,6 +19,9 @@ AHoloGameMode::AHoloGameMode()
 	PlayerColors.Add(FLinearColor::Yellow);
 	
 	LastPlayerColorIndex = -1;
+	MaxPooledPawns = 16;
+
+	GameStateClass = AHoloGameState::StaticClass();
 }
 
 void AHoloGameMode::BeginPlay()
@@ -35,15 +41,70 @@ void AHoloGameMode::SetPlayerDefaults(APawn* PlayerPawn)
 
 AActor* AHoloGameMode::FindPlayerStart_Implementation(AController* Player, const FString& IncomingName)
 {
-	if (StartActors.Num() <= 0)
+	HOLO_SCOPED_TIMING(FindPlayerStart);
+
+	UHoloSpawnSelectionSubsystem* SpawnSelection = GetWorld()->GetSubsystem<UHoloSpawnSelectionSubsystem>();
+	check(SpawnSelection);
+
+	AActor* StartSpot = SpawnSelection->Auth_SelectPlayerStart(Player);
+	checkf(StartSpot, TEXT("There is no PlayerStart on the map"));
+
+	return StartSpot;
+}
+
+void AHoloGameMode::RestartPlayerAtPlayerStart(AController* NewPlayer, AActor* StartSpot)
+{
+	// A player respawning after death keeps its pawn and weapon: bring them back to life at the start spot,
+	// the engine will then just possess the existing pawn again instead of spawning a new one
+	AHoloPawn* HoloPawn = NewPlayer ? Cast<AHoloPawn>(NewPlayer->GetPawn()) : nullptr;
+	if (HoloPawn && HoloPawn->bIsDying && StartSpot)
 	{
-		UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), StartActors);
+		const FRotator StartRotation(0.0f, StartSpot->GetActorRotation().Yaw, 0.0f);
+		HoloPawn->Auth_ResetForRespawn(StartSpot->GetActorLocation(), StartRotation);
 	}
 
-	checkf(StartActors.Num() > 0, TEXT("There is no PlayerStart on the map"));
-	
-	const int32 Index = FMath::RandRange(0, StartActors.Num() - 1);
-	return StartActors[Index];
+	Super::RestartPlayerAtPlayerStart(NewPlayer, StartSpot);
+}
+
+APawn* AHoloGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	AHoloPawn* PooledPawn = AcquirePooledPawn(GetDefaultPawnClassForController(NewPlayer));
+	if (PooledPawn)
+	{
+		PooledPawn->Auth_ResetForRespawn(SpawnTransform.GetLocation(), SpawnTransform.Rotator());
+		return PooledPawn;
+	}
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+bool AHoloGameMode::Auth_ReleasePawn(AHoloPawn* HoloPawn)
+{
+	check(HoloPawn);
+
+	if (PooledPawns.Num() >= MaxPooledPawns)
+	{
+		return false;
+	}
+
+	HoloPawn->Auth_Deactivate();
+	PooledPawns.Add(HoloPawn);
+	return true;
+}
+
+AHoloPawn* AHoloGameMode::AcquirePooledPawn(UClass* PawnClass)
+{
+	for (int32 Index = 0; Index < PooledPawns.Num(); ++Index)
+	{
+		AHoloPawn* HoloPawn = PooledPawns[Index];
+		if (HoloPawn && !HoloPawn->IsPendingKill() && HoloPawn->GetClass() == PawnClass)
+		{
+			PooledPawns.RemoveAtSwap(Index);
+			return HoloPawn;
+		}
+	}
+
+	return nullptr;
 }
 
 void AHoloGameMode::SetPlayerColor(AHoloPawn* HoloPawn)
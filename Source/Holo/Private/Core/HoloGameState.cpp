@@ -0,0 +1,33 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloGameState.h"
+
+#include "Holo.h"
+#include "Core/HoloAssetPreloadSubsystem.h"
+#include "Core/HoloGameMode.h"
+
+void AHoloGameState::ReceivedGameModeClass()
+{
+	Super::ReceivedGameModeClass();
+
+	// Known on the server at startup, and on clients as soon as the game state replicates: start streaming the game content
+	const AHoloGameMode* GameMode = GameModeClass ? Cast<AHoloGameMode>(GameModeClass->GetDefaultObject()) : nullptr;
+	UHoloAssetPreloadSubsystem* Preload = GetWorld()->GetSubsystem<UHoloAssetPreloadSubsystem>();
+	if (GameMode && Preload)
+	{
+		Preload->PreloadGameContent(GameMode);
+	}
+}
+
+void AHoloGameState::Auth_NotifyKill(APlayerState* Killer, APlayerState* Victim)
+{
+	checkf(HasAuthority(), TEXT("AHoloGameState::Auth_NotifyKill called on client"));
+
+	Multicast_NotifyKill(Killer, Victim);
+}
+
+void AHoloGameState::Multicast_NotifyKill_Implementation(APlayerState* Killer, APlayerState* Victim)
+{
+	OnKillDelegate.Broadcast(Killer, Victim);
+}
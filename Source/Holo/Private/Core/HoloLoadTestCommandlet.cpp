@@ -0,0 +1,115 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloLoadTestCommandlet.h"
+
+#include "Holo.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+UHoloLoadTestCommandlet::UHoloLoadTestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UHoloLoadTestCommandlet::Main(const FString& Params)
+{
+	int32 NumClients = 16;
+	int32 ClientsPerStep = 4;
+	float StepInterval = 10.0f;
+	float Duration = 120.0f;
+	int32 Port = 7777;
+	FString Map = TEXT("/Game/Holo/Maps/DevMap");
+	FString CsvPath = FPaths::ProjectSavedDir() / TEXT("LoadTest") / FDateTime::Now().ToString() + TEXT(".csv");
+
+	FParse::Value(*Params, TEXT("Clients="), NumClients);
+	FParse::Value(*Params, TEXT("Step="), ClientsPerStep);
+	FParse::Value(*Params, TEXT("StepInterval="), StepInterval);
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Map="), Map);
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+
+	NumClients = FMath::Max(NumClients, 0);
+	ClientsPerStep = FMath::Max(ClientsPerStep, 1);
+	CsvPath = FPaths::ConvertRelativePathToFull(CsvPath);
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(CsvPath), true);
+	IFileManager::Get().Delete(*CsvPath);
+
+	// Game processes are started from the same executable, without an editor
+	const FString Executable = FPlatformProcess::ExecutablePath();
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+
+	TArray<FProcHandle> Processes;
+	auto Launch = [&](const FString& Arguments)
+	{
+		FProcHandle Handle = FPlatformProcess::CreateProc(*Executable, *Arguments, true, true, true, nullptr, 0, nullptr, nullptr);
+		if (!Handle.IsValid())
+		{
+			UE_LOG(LogHolo, Error, TEXT("Unable to launch %s %s"), *Executable, *Arguments);
+			return false;
+		}
+
+		Processes.Add(Handle);
+		return true;
+	};
+
+	const FString ServerArguments = FString::Printf(TEXT("\"%s\" %s -server -nullrhi -unattended -log -Port=%d -HoloLoadTestCsv=\"%s\""),
+		*ProjectFile, *Map, Port, *CsvPath);
+	if (!Launch(ServerArguments))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogHolo, Display, TEXT("Load test: server started, recording to %s"), *CsvPath);
+
+	// Give the server some time to load the map before clients connect
+	FPlatformProcess::Sleep(StepInterval);
+
+	const FString ClientArguments = FString::Printf(TEXT("\"%s\" 127.0.0.1:%d -game -nullrhi -nosound -unattended -HoloBot"), *ProjectFile, Port);
+	int32 NumLaunchedClients = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	double NextStepTime = StartTime;
+	bool bSucceeded = true;
+
+	while (FPlatformTime::Seconds() - StartTime < Duration)
+	{
+		if (!FPlatformProcess::IsProcRunning(Processes[0]))
+		{
+			UE_LOG(LogHolo, Error, TEXT("Load test: server exited early"));
+			bSucceeded = false;
+			break;
+		}
+
+		if (NumLaunchedClients < NumClients && FPlatformTime::Seconds() >= NextStepTime)
+		{
+			const int32 NumToLaunch = FMath::Min(ClientsPerStep, NumClients - NumLaunchedClients);
+			for (int32 Index = 0; Index < NumToLaunch; ++Index)
+			{
+				if (Launch(ClientArguments))
+				{
+					++NumLaunchedClients;
+				}
+			}
+
+			UE_LOG(LogHolo, Display, TEXT("Load test: %d/%d clients launched"), NumLaunchedClients, NumClients);
+			NextStepTime += StepInterval;
+		}
+
+		FPlatformProcess::Sleep(1.0f);
+	}
+
+	// Clients first, so the server records their disconnection
+	for (int32 Index = Processes.Num() - 1; Index >= 0; --Index)
+	{
+		FPlatformProcess::TerminateProc(Processes[Index], true);
+		FPlatformProcess::CloseProc(Processes[Index]);
+	}
+
+	UE_LOG(LogHolo, Display, TEXT("Load test finished, results in %s"), *CsvPath);
+	return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloSpawnSelectionSubsystem.h"
+
+#include "Holo.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "Player/HoloPawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Selection Update"), STAT_HoloSpawnSelectionUpdate, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Select Player Start"), STAT_HoloSelectPlayerStart, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Line Of Sight Traces"), STAT_HoloSpawnLineOfSightTraces, STATGROUP_Holo);
+
+namespace HoloSpawnSelection
+{
+	/** The start points generation is stored in the top bits of the trace user data, the start index in the others. */
+	static constexpr uint32 GenerationShift = 24;
+	static constexpr uint32 IndexMask = (1u << GenerationShift) - 1;
+
+	/** Player starts scoring within this much of the best one are considered equally good, and picked at random. */
+	static constexpr float ScoreTolerance = 0.01f;
+}
+
+void UHoloSpawnSelectionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UHoloSpawnSelectionSubsystem::OnLineOfSightTraceCompleted);
+
+	// Streamed levels bring their own player starts
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UHoloSpawnSelectionSubsystem::OnLevelsChanged);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UHoloSpawnSelectionSubsystem::OnLevelsChanged);
+}
+
+void UHoloSpawnSelectionSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	Super::Deinitialize();
+}
+
+void UHoloSpawnSelectionSubsystem::Tick(float DeltaTime)
+{
+	if (!IsServerWorld())
+	{
+		return;
+	}
+
+	HOLO_SCOPED_TIMING(SpawnSelectionUpdate);
+
+	if (bStartPointsDirty)
+	{
+		RebuildStartPoints();
+	}
+
+	if (StartPoints.Num() == 0)
+	{
+		return;
+	}
+
+	// Last frame's traces have completed: publish their counts
+	for (const int32 StartIndex : InFlightStarts)
+	{
+		VisiblePawnCounts[StartIndex] = PendingVisiblePawnCounts[StartIndex];
+	}
+	InFlightStarts.Reset();
+
+	GatherLivingPawns();
+
+	TimeSinceProximityUpdate += DeltaTime;
+	if (TimeSinceProximityUpdate >= ProximityUpdateInterval)
+	{
+		TimeSinceProximityUpdate = 0.0f;
+		UpdateProximityScores();
+	}
+
+	IssueLineOfSightTraces();
+}
+
+TStatId UHoloSpawnSelectionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloSpawnSelectionSubsystem, STATGROUP_Tickables);
+}
+
+AActor* UHoloSpawnSelectionSubsystem::Auth_SelectPlayerStart(const AController* Player)
+{
+	checkf(IsServerWorld(), TEXT("UHoloSpawnSelectionSubsystem::Auth_SelectPlayerStart called on client"));
+
+	HOLO_SCOPED_TIMING(SelectPlayerStart);
+
+	// Players may need a start before the first tick, e.g. when joining as the map loads
+	if (bStartPointsDirty)
+	{
+		RebuildStartPoints();
+		GatherLivingPawns();
+		UpdateProximityScores();
+	}
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	TArray<float, TInlineAllocator<64>> Scores;
+	Scores.SetNumUninitialized(StartPoints.Num());
+
+	float BestScore = MAX_flt;
+	for (int32 Index = 0; Index < StartPoints.Num(); ++Index)
+	{
+		if (!IsValid(StartPoints[Index]))
+		{
+			Scores[Index] = MAX_flt;
+			continue;
+		}
+
+		const float RecentUseAlpha = RecentUseTime > 0.0f ? FMath::Clamp(1.0f - (CurrentTime - LastUseTimes[Index]) / RecentUseTime, 0.0f, 1.0f) : 0.0f;
+		Scores[Index] = ProximityScores[Index] * ProximityWeight
+			+ VisiblePawnCounts[Index] * LineOfSightWeight
+			+ RecentUseAlpha * RecentUseWeight;
+		BestScore = FMath::Min(BestScore, Scores[Index]);
+	}
+
+	if (BestScore == MAX_flt)
+	{
+		return nullptr;
+	}
+
+	// Break ties at random, so that a quiet map doesn't always spawn everyone at the same place
+	TArray<int32, TInlineAllocator<64>> Candidates;
+	for (int32 Index = 0; Index < Scores.Num(); ++Index)
+	{
+		if (Scores[Index] <= BestScore + HoloSpawnSelection::ScoreTolerance)
+		{
+			Candidates.Add(Index);
+		}
+	}
+
+	const int32 Selected = Candidates[FMath::RandRange(0, Candidates.Num() - 1)];
+	LastUseTimes[Selected] = CurrentTime;
+	return StartPoints[Selected];
+}
+
+void UHoloSpawnSelectionSubsystem::OnLevelsChanged(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		bStartPointsDirty = true;
+	}
+}
+
+void UHoloSpawnSelectionSubsystem::RebuildStartPoints()
+{
+	bStartPointsDirty = false;
+	++StartPointsGeneration;
+
+	StartPoints.Reset();
+	StartLocations.Reset();
+	Grid.Reset();
+	InFlightStarts.Reset();
+	NextLineOfSightStart = 0;
+
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		APlayerStart* StartPoint = *It;
+		const int32 Index = StartPoints.Add(StartPoint);
+		StartLocations.Add(StartPoint->GetActorLocation());
+		Grid.FindOrAdd(GetCell(StartLocations[Index])).Add(Index);
+	}
+
+	const int32 NumStartPoints = StartPoints.Num();
+	ProximityScores.Init(0.0f, NumStartPoints);
+	VisiblePawnCounts.Init(0, NumStartPoints);
+	PendingVisiblePawnCounts.Init(0, NumStartPoints);
+	LastUseTimes.Init(-MAX_flt, NumStartPoints);
+}
+
+void UHoloSpawnSelectionSubsystem::GatherLivingPawns()
+{
+	LivingPawnLocations.Reset();
+	for (TActorIterator<AHoloPawn> It(GetWorld()); It; ++It)
+	{
+		const AHoloPawn* Pawn = *It;
+		if (!Pawn->bIsDying && !Pawn->IsHidden())
+		{
+			LivingPawnLocations.Add(Pawn->GetPawnViewLocation());
+		}
+	}
+}
+
+void UHoloSpawnSelectionSubsystem::UpdateProximityScores()
+{
+	FMemory::Memzero(ProximityScores.GetData(), ProximityScores.Num() * sizeof(float));
+
+	if (DangerRadius <= 0.0f)
+	{
+		return;
+	}
+
+	// Only visit the player starts of the cells overlapping the danger radius of each pawn
+	const float DangerRadiusSquared = FMath::Square(DangerRadius);
+	for (const FVector& PawnLocation : LivingPawnLocations)
+	{
+		const FIntPoint MinCell = GetCell(PawnLocation - FVector(DangerRadius));
+		const FIntPoint MaxCell = GetCell(PawnLocation + FVector(DangerRadius));
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+			{
+				const TArray<int32>* CellStarts = Grid.Find(FIntPoint(CellX, CellY));
+				if (!CellStarts)
+				{
+					continue;
+				}
+
+				for (const int32 StartIndex : *CellStarts)
+				{
+					const float DistanceSquared = FVector::DistSquared(PawnLocation, StartLocations[StartIndex]);
+					if (DistanceSquared < DangerRadiusSquared)
+					{
+						ProximityScores[StartIndex] += 1.0f - FMath::Sqrt(DistanceSquared) / DangerRadius;
+					}
+				}
+			}
+		}
+	}
+}
+
+void UHoloSpawnSelectionSubsystem::IssueLineOfSightTraces()
+{
+	UWorld* World = GetWorld();
+	const float RangeSquared = FMath::Square(LineOfSightRange);
+	const FCollisionQueryParams QueryParams(TEXT("SpawnLineOfSight"), false);
+
+	// Only level geometry hides a player start: pawns move, and traces would start inside their own capsule
+	const FCollisionObjectQueryParams ObjectQueryParams(ECC_WorldStatic);
+	const int32 NumStartPoints = StartPoints.Num();
+
+	int32 NumTraces = 0;
+	for (int32 Visited = 0; Visited < NumStartPoints && (Visited == 0 || NumTraces < MaxTracesPerFrame); ++Visited)
+	{
+		const int32 StartIndex = NextLineOfSightStart;
+		NextLineOfSightStart = (NextLineOfSightStart + 1) % NumStartPoints;
+
+		PendingVisiblePawnCounts[StartIndex] = 0;
+		InFlightStarts.Add(StartIndex);
+
+		const FVector Target = StartLocations[StartIndex] + FVector(0.0f, 0.0f, LineOfSightHeight);
+		const uint32 UserData = ((StartPointsGeneration & 0xFF) << HoloSpawnSelection::GenerationShift) | static_cast<uint32>(StartIndex);
+		for (const FVector& PawnLocation : LivingPawnLocations)
+		{
+			if (FVector::DistSquared(PawnLocation, Target) <= RangeSquared)
+			{
+				World->AsyncLineTraceByObjectType(EAsyncTraceType::Test, PawnLocation, Target, ObjectQueryParams, QueryParams, &TraceDelegate, UserData);
+				++NumTraces;
+			}
+		}
+	}
+
+	HOLO_INC_COUNTER(SpawnLineOfSightTraces, NumTraces);
+}
+
+void UHoloSpawnSelectionSubsystem::OnLineOfSightTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const uint32 Generation = Datum.UserData >> HoloSpawnSelection::GenerationShift;
+	const int32 StartIndex = static_cast<int32>(Datum.UserData & HoloSpawnSelection::IndexMask);
+	if (Generation != (StartPointsGeneration & 0xFF) || !PendingVisiblePawnCounts.IsValidIndex(StartIndex))
+	{
+		return;
+	}
+
+	// Nothing blocking the way: that pawn can see the player start
+	const bool bBlocked = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+	if (!bBlocked)
+	{
+		++PendingVisiblePawnCounts[StartIndex];
+	}
+}
+
+FIntPoint UHoloSpawnSelectionSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
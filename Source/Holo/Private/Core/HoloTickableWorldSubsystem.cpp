@@ -0,0 +1,46 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/HoloTickableWorldSubsystem.h"
+
+bool UHoloTickableWorldSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UHoloTickableWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bInitialized = true;
+}
+
+void UHoloTickableWorldSubsystem::Deinitialize()
+{
+	bInitialized = false;
+
+	Super::Deinitialize();
+}
+
+ETickableTickType UHoloTickableWorldSubsystem::GetTickableTickType() const
+{
+	// The CDO is registered as a tickable object as well, make sure it never ticks
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UHoloTickableWorldSubsystem::IsTickable() const
+{
+	return bInitialized;
+}
+
+UWorld* UHoloTickableWorldSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+bool UHoloTickableWorldSubsystem::IsServerWorld() const
+{
+	const UWorld* World = GetWorld();
+	return World && World->GetNetMode() != NM_Client;
+}
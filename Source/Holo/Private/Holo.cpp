@@ -1,6 +1,59 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Holo.h"
+#include "Engine/NetDriver.h"
+#include "Engine/ReplicationDriver.h"
+#include "Engine/World.h"
 #include "Modules/ModuleManager.h"
+#include "Net/HoloReplicationGraph.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Holo, "Holo" );
+static TAutoConsoleVariable<bool> CVarUseReplicationGraph(
+	TEXT("Holo.UseReplicationGraph"),
+	true,
+	TEXT("If true, game servers replicate through UHoloReplicationGraph, otherwise through the legacy net driver relevancy loop.\n")
+	TEXT("Read when the server starts listening: set it in the [ConsoleVariables] section of the engine ini, or from the command line with -ini:Engine:[ConsoleVariables]:Holo.UseReplicationGraph=0"),
+	ECVF_Default);
+
+class FHoloGameModule : public FDefaultGameModuleImpl
+{
+public:
+
+	virtual void StartupModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().BindLambda([](UNetDriver* ForNetDriver, const FURL& URL, UWorld* World) -> UReplicationDriver*
+		{
+			// Only the game net driver uses the graph, beacons and demo recording keep the default behavior
+			if (!CVarUseReplicationGraph.GetValueOnGameThread() || !ForNetDriver || ForNetDriver->NetDriverName != NAME_GameNetDriver)
+			{
+				return nullptr;
+			}
+
+			return NewObject<UHoloReplicationGraph>(GetTransientPackage());
+		});
+	}
+
+	virtual void ShutdownModule() override
+	{
+		UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FHoloGameModule, Holo, "Holo" );
+
+DEFINE_LOG_CATEGORY(LogHolo);
+
+DEFINE_STAT(STAT_HoloWidgetPaints);
+
+CSV_DEFINE_CATEGORY_MODULE(HOLO_API, Holo, true);
+
+UE_TRACE_CHANNEL_DEFINE(HoloChannel);
+
+bool Holo::ShouldPlayCosmetics(const UObject* WorldContextObject)
+{
+#if WITH_HOLO_COSMETICS
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World && World->GetNetMode() != NM_DedicatedServer;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,155 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/HoloFireValidationSubsystem.h"
+
+#include "Holo.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/GameSession.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Packets Dropped"), STAT_HoloFirePacketsDropped, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots Rejected"), STAT_HoloShotsRejected, STATGROUP_Holo);
+
+bool UHoloFireValidationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UHoloFireValidationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	MinViewDot = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(MaxViewDivergenceAngle, 0.0f, 180.0f)));
+	LogoutHandle = FGameModeEvents::GameModeLogoutEvent.AddUObject(this, &UHoloFireValidationSubsystem::OnLogout);
+}
+
+void UHoloFireValidationSubsystem::Deinitialize()
+{
+	FGameModeEvents::GameModeLogoutEvent.Remove(LogoutHandle);
+	PlayerStats.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UHoloFireValidationSubsystem::Auth_ValidatePacket(APlayerController* Player, int32 NumCommands)
+{
+	checkf(GetWorld()->GetNetMode() != NM_Client, TEXT("UHoloFireValidationSubsystem::Auth_ValidatePacket called on client"));
+
+	const float CurrentTime = GetWorld()->GetRealTimeSeconds();
+	FPlayerFireStats& Stats = GetPlayerStats(Player, CurrentTime);
+	FWindowBucket& Bucket = Stats.Buckets[Stats.CurrentBucket % NumWindowBuckets];
+
+	// Token bucket: refill according to the time elapsed since the last packet, spend one token per packet
+	Stats.PacketTokens = FMath::Min(Stats.PacketTokens + (CurrentTime - Stats.LastPacketTime) * MaxPacketsPerSecond, MaxPacketBurst);
+	Stats.LastPacketTime = CurrentTime;
+
+	if (Stats.PacketTokens < 1.0f)
+	{
+		++Bucket.DroppedPackets;
+		HOLO_INC_COUNTER(FirePacketsDropped, 1);
+		CheckForKick(Player, Stats);
+		return false;
+	}
+
+	Stats.PacketTokens -= 1.0f;
+	++Bucket.Packets;
+	Bucket.Commands += NumCommands;
+	return !Stats.bKicked;
+}
+
+bool UHoloFireValidationSubsystem::Auth_ValidateShot(APlayerController* Player, const FVector& ClientMuzzleLocation, const FVector& ServerMuzzleLocation, const FVector& Direction)
+{
+	checkf(GetWorld()->GetNetMode() != NM_Client, TEXT("UHoloFireValidationSubsystem::Auth_ValidateShot called on client"));
+
+	// The listen server's own shots never went through the network
+	if (!Player || Player->IsLocalController())
+	{
+		return true;
+	}
+
+	const bool bMuzzleIsPlausible = FVector::DistSquared(ClientMuzzleLocation, ServerMuzzleLocation) <= FMath::Square(MaxMuzzleError);
+
+	// The weapon follows what's under the crosshair, which can diverge a bit from the view direction at close range
+	const FVector ViewDirection = Player->GetControlRotation().Vector();
+	const bool bDirectionIsPlausible = (Direction | ViewDirection) >= MinViewDot;
+
+	if (bMuzzleIsPlausible && bDirectionIsPlausible)
+	{
+		return true;
+	}
+
+	FPlayerFireStats& Stats = GetPlayerStats(Player, GetWorld()->GetRealTimeSeconds());
+	++Stats.Buckets[Stats.CurrentBucket % NumWindowBuckets].RejectedShots;
+	HOLO_INC_COUNTER(ShotsRejected, 1);
+
+	UE_LOG(LogHolo, Verbose, TEXT("Rejected shot of %s: muzzle %s, direction %s"), *Player->GetName(),
+		bMuzzleIsPlausible ? TEXT("ok") : TEXT("implausible"), bDirectionIsPlausible ? TEXT("ok") : TEXT("implausible"));
+
+	CheckForKick(Player, Stats);
+	return false;
+}
+
+void UHoloFireValidationSubsystem::OnLogout(AGameModeBase* GameMode, AController* Exiting)
+{
+	if (GameMode && GameMode->GetWorld() == GetWorld())
+	{
+		PlayerStats.Remove(Cast<APlayerController>(Exiting));
+	}
+}
+
+UHoloFireValidationSubsystem::FPlayerFireStats& UHoloFireValidationSubsystem::GetPlayerStats(APlayerController* Player, float CurrentTime)
+{
+	FPlayerFireStats* Stats = PlayerStats.Find(Player);
+	if (!Stats)
+	{
+		Stats = &PlayerStats.Add(Player);
+		Stats->PacketTokens = MaxPacketBurst;
+		Stats->LastPacketTime = CurrentTime;
+	}
+
+	// Clear the buckets we've moved past since the last update, at most the whole window
+	const int64 Bucket = static_cast<int64>(CurrentTime / FMath::Max(WindowBucketDuration, KINDA_SMALL_NUMBER));
+	const int64 NumElapsedBuckets = FMath::Min<int64>(Bucket - Stats->CurrentBucket, NumWindowBuckets);
+	for (int64 Index = 1; Index <= NumElapsedBuckets; ++Index)
+	{
+		Stats->Buckets[(Stats->CurrentBucket + Index) % NumWindowBuckets] = FWindowBucket();
+	}
+	Stats->CurrentBucket = FMath::Max(Stats->CurrentBucket, Bucket);
+
+	return *Stats;
+}
+
+void UHoloFireValidationSubsystem::CheckForKick(APlayerController* Player, FPlayerFireStats& Stats)
+{
+	if (Stats.bKicked)
+	{
+		return;
+	}
+
+	int32 DroppedPackets = 0;
+	int32 RejectedShots = 0;
+	for (const FWindowBucket& Bucket : Stats.Buckets)
+	{
+		DroppedPackets += Bucket.DroppedPackets;
+		RejectedShots += Bucket.RejectedShots;
+	}
+
+	if (DroppedPackets < KickDroppedPackets && RejectedShots < KickRejectedShots)
+	{
+		return;
+	}
+
+	AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+	if (!GameMode || !GameMode->GameSession)
+	{
+		return;
+	}
+
+	UE_LOG(LogHolo, Warning, TEXT("Kicking %s: %d fire packets dropped and %d shots rejected over the last %.1fs"),
+		*Player->GetName(), DroppedPackets, RejectedShots, NumWindowBuckets * WindowBucketDuration);
+
+	Stats.bKicked = true;
+	GameMode->GameSession->KickPlayer(Player, NSLOCTEXT("Holo", "KickedForInvalidFire", "Invalid fire commands"));
+}
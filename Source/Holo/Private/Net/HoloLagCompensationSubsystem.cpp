@@ -0,0 +1,249 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/HoloLagCompensationSubsystem.h"
+
+#include "Holo.h"
+#include "Components/CapsuleComponent.h"
+#include "Player/HoloPawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_HoloLagCompensationRecord, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_HoloLagCompensationRewind, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensated Shots"), STAT_HoloLagCompensatedShots, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rewound Pawns"), STAT_HoloRewoundPawns, STATGROUP_Holo);
+
+void UHoloLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Allocate all of the storage up front: recording and rewinding must never allocate
+	TrackedPawns.SetNum(MaxTrackedPawns);
+	BoundsRadii.SetNumZeroed(MaxTrackedPawns);
+	FirstSampleSerials.SetNumZeroed(MaxTrackedPawns);
+	SampleTimes.SetNumZeroed(HistoryLength);
+	SampleSerials.SetNumZeroed(HistoryLength);
+	SampleLocations.SetNumZeroed(HistoryLength * MaxTrackedPawns);
+}
+
+void UHoloLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	if (NumTrackedPawns <= 0 || !IsServerWorld())
+	{
+		return;
+	}
+
+	HOLO_SCOPED_TIMING(LagCompensationRecord);
+
+	HeadSample = (HeadSample + 1) % HistoryLength;
+	NumSamples = FMath::Min(NumSamples + 1, HistoryLength);
+	SampleTimes[HeadSample] = GetWorld()->GetTimeSeconds();
+	SampleSerials[HeadSample] = NextSampleSerial++;
+
+	FVector* Row = &SampleLocations[HeadSample * MaxTrackedPawns];
+	for (int32 Slot = 0; Slot < MaxTrackedPawns; ++Slot)
+	{
+		if (const AHoloPawn* Pawn = TrackedPawns[Slot].Get())
+		{
+			Row[Slot] = Pawn->GetActorLocation();
+		}
+	}
+}
+
+TStatId UHoloLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloLagCompensationSubsystem::RegisterPawn(AHoloPawn* Pawn)
+{
+	check(Pawn);
+
+	if (FindSlot(Pawn) != INDEX_NONE)
+	{
+		return;
+	}
+
+	for (int32 Slot = 0; Slot < MaxTrackedPawns; ++Slot)
+	{
+		if (!TrackedPawns[Slot].IsValid())
+		{
+			// Slots left behind by pawns that were never unregistered are still counted
+			if (TrackedPawns[Slot].IsExplicitlyNull())
+			{
+				++NumTrackedPawns;
+			}
+
+			const UCapsuleComponent* Capsule = Pawn->GetCapsuleComponent();
+			TrackedPawns[Slot] = Pawn;
+			BoundsRadii[Slot] = Capsule ? Capsule->GetScaledCapsuleHalfHeight() : Pawn->GetSimpleCollisionRadius();
+			FirstSampleSerials[Slot] = NextSampleSerial;
+			return;
+		}
+	}
+
+	UE_LOG(LogHolo, Warning, TEXT("Lag compensation can't track more than %d pawns, %s won't be rewound"), MaxTrackedPawns, *GetNameSafe(Pawn));
+}
+
+void UHoloLagCompensationSubsystem::UnregisterPawn(AHoloPawn* Pawn)
+{
+	const int32 Slot = FindSlot(Pawn);
+	if (Slot != INDEX_NONE)
+	{
+		TrackedPawns[Slot].Reset();
+		--NumTrackedPawns;
+	}
+}
+
+void UHoloLagCompensationSubsystem::ResetPawnHistory(AHoloPawn* Pawn)
+{
+	const int32 Slot = FindSlot(Pawn);
+	if (Slot != INDEX_NONE)
+	{
+		FirstSampleSerials[Slot] = NextSampleSerial;
+	}
+}
+
+float UHoloLagCompensationSubsystem::GetRewindTime(float ClientFireTime) const
+{
+	// GetServerWorldTimeSeconds on the client lags behind the server by the one-way latency,
+	// which is also how old the simulated proxies the client was aiming at are: no further correction is needed.
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ClientFireTime, CurrentTime - MaxRewindTime, CurrentTime);
+}
+
+bool UHoloLagCompensationSubsystem::LineTraceAtTime(FHitResult& OutHit, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, float RewindTime)
+{
+	HOLO_SCOPED_TIMING(LagCompensationRewind);
+	HOLO_INC_COUNTER(LagCompensatedShots, 1);
+
+	UWorld* World = GetWorld();
+
+	int32 OlderSample;
+	int32 NewerSample;
+	float Alpha;
+	if (!FindSamplesAtTime(RewindTime, OlderSample, NewerSample, Alpha))
+	{
+		return World->LineTraceSingleByProfile(OutHit, Start, End, ProfileName, Params);
+	}
+
+	struct FRewoundPawn
+	{
+		AHoloPawn* Pawn;
+		FVector RestoreLocation;
+	};
+	TArray<FRewoundPawn, TInlineAllocator<8>> RewoundPawns;
+
+	const TArray<uint32>& IgnoredActors = Params.GetIgnoredActors();
+	for (int32 Slot = 0; Slot < MaxTrackedPawns; ++Slot)
+	{
+		AHoloPawn* Pawn = TrackedPawns[Slot].Get();
+		if (!Pawn || Pawn->bIsDying || IgnoredActors.Contains(Pawn->GetUniqueID()))
+		{
+			continue;
+		}
+
+		FVector RewoundLocation;
+		if (!GetRewoundLocation(Slot, OlderSample, NewerSample, Alpha, RewoundLocation))
+		{
+			continue;
+		}
+
+		// Broad-phase: only move pawns whose bounds touch the trace either where they were or where they are now,
+		// otherwise their current collision could block a shot that should have missed them
+		const FVector CurrentLocation = Pawn->GetActorLocation();
+		const float BoundsRadiusSq = FMath::Square(BoundsRadii[Slot] + BroadPhaseMargin);
+		if (FMath::PointDistToSegmentSquared(RewoundLocation, Start, End) > BoundsRadiusSq
+			&& FMath::PointDistToSegmentSquared(CurrentLocation, Start, End) > BoundsRadiusSq)
+		{
+			continue;
+		}
+
+		if (RewoundLocation.Equals(CurrentLocation, 1.0f))
+		{
+			continue;
+		}
+
+		RewoundPawns.Add({ Pawn, CurrentLocation });
+		Pawn->SetActorLocation(RewoundLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	HOLO_INC_COUNTER(RewoundPawns, RewoundPawns.Num());
+
+	const bool bHit = World->LineTraceSingleByProfile(OutHit, Start, End, ProfileName, Params);
+
+	for (const FRewoundPawn& RewoundPawn : RewoundPawns)
+	{
+		RewoundPawn.Pawn->SetActorLocation(RewoundPawn.RestoreLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	return bHit;
+}
+
+int32 UHoloLagCompensationSubsystem::FindSlot(const AHoloPawn* Pawn) const
+{
+	for (int32 Slot = 0; Slot < TrackedPawns.Num(); ++Slot)
+	{
+		if (TrackedPawns[Slot].Get() == Pawn)
+		{
+			return Slot;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+bool UHoloLagCompensationSubsystem::FindSamplesAtTime(float Time, int32& OutOlderSample, int32& OutNewerSample, float& OutAlpha) const
+{
+	// Nothing to rewind into, or the requested time isn't in the past
+	if (NumSamples <= 0 || Time >= SampleTimes[HeadSample])
+	{
+		return false;
+	}
+
+	int32 NewerSample = HeadSample;
+	for (int32 Step = 1; Step < NumSamples; ++Step)
+	{
+		const int32 OlderSample = (HeadSample - Step + HistoryLength) % HistoryLength;
+		if (SampleTimes[OlderSample] <= Time)
+		{
+			const float Span = SampleTimes[NewerSample] - SampleTimes[OlderSample];
+			OutOlderSample = OlderSample;
+			OutNewerSample = NewerSample;
+			OutAlpha = Span > KINDA_SMALL_NUMBER ? (Time - SampleTimes[OlderSample]) / Span : 1.0f;
+			return true;
+		}
+
+		NewerSample = OlderSample;
+	}
+
+	// Older than our whole history: use the oldest sample we have
+	OutOlderSample = NewerSample;
+	OutNewerSample = NewerSample;
+	OutAlpha = 0.0f;
+	return true;
+}
+
+bool UHoloLagCompensationSubsystem::GetRewoundLocation(int32 Slot, int32 OlderSample, int32 NewerSample, float Alpha, FVector& OutLocation) const
+{
+	const uint32 FirstSerial = FirstSampleSerials[Slot];
+	const bool bOlderIsValid = SampleSerials[OlderSample] >= FirstSerial;
+	const bool bNewerIsValid = SampleSerials[NewerSample] >= FirstSerial;
+
+	const FVector& OlderLocation = SampleLocations[OlderSample * MaxTrackedPawns + Slot];
+	const FVector& NewerLocation = SampleLocations[NewerSample * MaxTrackedPawns + Slot];
+
+	if (bOlderIsValid && bNewerIsValid)
+	{
+		OutLocation = FMath::Lerp(OlderLocation, NewerLocation, Alpha);
+		return true;
+	}
+
+	if (bNewerIsValid)
+	{
+		// The pawn wasn't tracked yet at the requested time: the earliest location we know is the best guess
+		OutLocation = NewerLocation;
+		return true;
+	}
+
+	return false;
+}
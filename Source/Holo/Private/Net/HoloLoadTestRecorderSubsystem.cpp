@@ -0,0 +1,175 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/HoloLoadTestRecorderSubsystem.h"
+
+#include "Holo.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+
+bool UHoloLoadTestRecorderSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString CsvPath;
+	return Super::ShouldCreateSubsystem(Outer) && FParse::Value(FCommandLine::Get(), TEXT("HoloLoadTestCsv="), CsvPath);
+}
+
+void UHoloLoadTestRecorderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString CsvPath;
+	FParse::Value(FCommandLine::Get(), TEXT("HoloLoadTestCsv="), CsvPath);
+
+	// Keep appending across map travels, so a whole session ends up in a single file
+	const bool bFileExists = IFileManager::Get().FileExists(*CsvPath);
+	CsvWriter.Reset(IFileManager::Get().CreateFileWriter(*CsvPath, FILEWRITE_Append | FILEWRITE_AllowRead));
+	if (!CsvWriter)
+	{
+		UE_LOG(LogHolo, Error, TEXT("Unable to open load test CSV file %s"), *CsvPath);
+		return;
+	}
+
+	if (!bFileExists)
+	{
+		WriteLine(TEXT("Time,Connections,AvgFrameMs,MaxFrameMs,AvgBusyMs,AvgOutBytesPerSecPerConnection,MaxOutBytesPerSecPerConnection,AvgInBytesPerSecPerConnection,TotalOutBytesPerSec,TotalInBytesPerSec,TotalOutPacketsPerSec,TotalInPacketsPerSec,SentRPCsPerSec"));
+	}
+
+	UE_LOG(LogHolo, Log, TEXT("Recording load test to %s"), *CsvPath);
+}
+
+void UHoloLoadTestRecorderSubsystem::Deinitialize()
+{
+	UnhookNetDriver();
+	CsvWriter.Reset();
+
+	Super::Deinitialize();
+}
+
+void UHoloLoadTestRecorderSubsystem::Tick(float DeltaTime)
+{
+	if (!CsvWriter || !IsServerWorld())
+	{
+		return;
+	}
+
+	// The net driver is only created once the server starts listening, after the subsystems
+	if (!HookedNetDriver.IsValid())
+	{
+		HookNetDriver();
+	}
+
+	// The server sleeps to cap its tick rate: the busy time is what it actually spent working
+	const double FrameTime = FApp::GetDeltaTime();
+	TotalFrameTime += FrameTime;
+	TotalBusyTime += FMath::Max(FrameTime - FApp::GetIdleTime(), 0.0);
+	MaxFrameTime = FMath::Max(MaxFrameTime, FrameTime);
+	++NumFrames;
+
+	TimeSinceLastSample += DeltaTime;
+	if (TimeSinceLastSample >= SampleInterval)
+	{
+		WriteSample();
+	}
+}
+
+TStatId UHoloLoadTestRecorderSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloLoadTestRecorderSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloLoadTestRecorderSubsystem::HookNetDriver()
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver)
+	{
+		return;
+	}
+
+	// Single-cast delegate: don't steal it from whoever else is hooking the driver, only the RPC column is lost
+	HookedNetDriver = NetDriver;
+	if (NetDriver->SendRPCDel.IsBound())
+	{
+		UE_LOG(LogHolo, Warning, TEXT("Net driver RPCs are already hooked, the load test won't record sent RPCs"));
+		return;
+	}
+
+	NetDriver->SendRPCDel.BindUObject(this, &UHoloLoadTestRecorderSubsystem::OnSendRPC);
+}
+
+void UHoloLoadTestRecorderSubsystem::UnhookNetDriver()
+{
+	UNetDriver* NetDriver = HookedNetDriver.Get();
+	if (NetDriver && NetDriver->SendRPCDel.IsBoundToObject(this))
+	{
+		NetDriver->SendRPCDel.Unbind();
+	}
+	HookedNetDriver.Reset();
+}
+
+void UHoloLoadTestRecorderSubsystem::OnSendRPC(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRPC)
+{
+	// Multicasts are sent to every connection the actor is relevant to: count the upper bound
+	const UNetDriver* NetDriver = HookedNetDriver.Get();
+	const bool bMulticast = Function && Function->HasAnyFunctionFlags(FUNC_NetMulticast);
+	NumSentRPCs += bMulticast && NetDriver ? NetDriver->ClientConnections.Num() : 1;
+}
+
+void UHoloLoadTestRecorderSubsystem::WriteLine(const FString& Line)
+{
+	FTCHARToUTF8 Converted(*(Line + LINE_TERMINATOR));
+	CsvWriter->Serialize(const_cast<ANSICHAR*>(Converted.Get()), Converted.Length());
+	CsvWriter->Flush();
+}
+
+void UHoloLoadTestRecorderSubsystem::WriteSample()
+{
+	int32 NumConnections = 0;
+	int64 TotalOutBytesPerSecond = 0;
+	int64 TotalInBytesPerSecond = 0;
+	int32 MaxOutBytesPerSecond = 0;
+	int64 TotalOutPacketsPerSecond = 0;
+	int64 TotalInPacketsPerSecond = 0;
+
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver)
+	{
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (Connection)
+			{
+				++NumConnections;
+				TotalOutBytesPerSecond += Connection->OutBytesPerSecond;
+				TotalInBytesPerSecond += Connection->InBytesPerSecond;
+				MaxOutBytesPerSecond = FMath::Max(MaxOutBytesPerSecond, Connection->OutBytesPerSecond);
+				TotalOutPacketsPerSecond += Connection->OutPacketsPerSecond;
+				TotalInPacketsPerSecond += Connection->InPacketsPerSecond;
+			}
+		}
+	}
+
+	const int32 SafeNumConnections = FMath::Max(NumConnections, 1);
+	const int32 SafeNumFrames = FMath::Max(NumFrames, 1);
+	WriteLine(FString::Printf(TEXT("%.2f,%d,%.3f,%.3f,%.3f,%lld,%d,%lld,%lld,%lld,%lld,%lld,%.1f"),
+		GetWorld()->GetTimeSeconds(),
+		NumConnections,
+		TotalFrameTime * 1000.0 / SafeNumFrames,
+		MaxFrameTime * 1000.0,
+		TotalBusyTime * 1000.0 / SafeNumFrames,
+		TotalOutBytesPerSecond / SafeNumConnections,
+		MaxOutBytesPerSecond,
+		TotalInBytesPerSecond / SafeNumConnections,
+		TotalOutBytesPerSecond,
+		TotalInBytesPerSecond,
+		TotalOutPacketsPerSecond,
+		TotalInPacketsPerSecond,
+		NumSentRPCs / TimeSinceLastSample));
+
+	TimeSinceLastSample = 0.0f;
+	NumFrames = 0;
+	TotalFrameTime = 0.0;
+	TotalBusyTime = 0.0;
+	MaxFrameTime = 0.0;
+	NumSentRPCs = 0;
+}
@@ -0,0 +1,117 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/HoloNetQuantize.h"
+
+namespace HoloNet
+{
+	static uint32 QuantizeUnitFloat(float Value, int32 NumBits)
+	{
+		const uint32 MaxValue = (1u << NumBits) - 1;
+		return static_cast<uint32>(FMath::RoundToInt(FMath::Clamp(Value * 0.5f + 0.5f, 0.0f, 1.0f) * MaxValue));
+	}
+
+	static float DequantizeUnitFloat(uint32 Value, int32 NumBits)
+	{
+		const uint32 MaxValue = (1u << NumBits) - 1;
+		return static_cast<float>(Value & MaxValue) / MaxValue * 2.0f - 1.0f;
+	}
+
+	static float SignNotZero(float Value)
+	{
+		return Value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+void HoloNet::SerializePackedTime(FArchive& Ar, float& Time)
+{
+	uint16 Milliseconds = Ar.IsSaving() ? static_cast<uint16>(FMath::RoundToInt(FMath::Max(Time, 0.0f) * 1000.0f) & 0xFFFF) : 0;
+	Ar << Milliseconds;
+
+	if (Ar.IsLoading())
+	{
+		Time = Milliseconds / 1000.0f;
+	}
+}
+
+float HoloNet::UnwrapPackedTime(float PackedTime, float ReferenceTime)
+{
+	float Delta = PackedTime - FMath::Fmod(FMath::Max(ReferenceTime, 0.0f), PackedTimePeriod);
+	if (Delta > PackedTimePeriod * 0.5f)
+	{
+		Delta -= PackedTimePeriod;
+	}
+	else if (Delta < -PackedTimePeriod * 0.5f)
+	{
+		Delta += PackedTimePeriod;
+	}
+
+	return ReferenceTime + Delta;
+}
+
+uint32 HoloNet::EncodeOctahedral(const FVector& Normal, int32 BitsPerComponent)
+{
+	const float L1Norm = FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z);
+	if (L1Norm <= SMALL_NUMBER)
+	{
+		return EncodeOctahedral(FVector::ForwardVector, BitsPerComponent);
+	}
+
+	float U = Normal.X / L1Norm;
+	float V = Normal.Y / L1Norm;
+
+	// Fold the lower hemisphere over the corners of the square
+	if (Normal.Z < 0.0f)
+	{
+		const float FoldedU = (1.0f - FMath::Abs(V)) * SignNotZero(U);
+		const float FoldedV = (1.0f - FMath::Abs(U)) * SignNotZero(V);
+		U = FoldedU;
+		V = FoldedV;
+	}
+
+	return QuantizeUnitFloat(U, BitsPerComponent) | (QuantizeUnitFloat(V, BitsPerComponent) << BitsPerComponent);
+}
+
+FVector HoloNet::DecodeOctahedral(uint32 Packed, int32 BitsPerComponent)
+{
+	const float U = DequantizeUnitFloat(Packed, BitsPerComponent);
+	const float V = DequantizeUnitFloat(Packed >> BitsPerComponent, BitsPerComponent);
+
+	FVector Normal(U, V, 1.0f - FMath::Abs(U) - FMath::Abs(V));
+	if (Normal.Z < 0.0f)
+	{
+		Normal.X = (1.0f - FMath::Abs(V)) * SignNotZero(U);
+		Normal.Y = (1.0f - FMath::Abs(U)) * SignNotZero(V);
+	}
+
+	return Normal.GetSafeNormal();
+}
+
+void HoloNet::SerializeOctahedralNormal(FArchive& Ar, FVector& Normal, int32 BitsPerComponent)
+{
+	check(BitsPerComponent > 0 && BitsPerComponent <= 16);
+
+	uint32 Packed = Ar.IsSaving() ? EncodeOctahedral(Normal, BitsPerComponent) : 0;
+	Ar.SerializeBits(&Packed, BitsPerComponent * 2);
+
+	if (Ar.IsLoading())
+	{
+		Normal = DecodeOctahedral(Packed, BitsPerComponent);
+	}
+}
+
+void HoloNet::SerializeQuantizedOffset(FArchive& Ar, FVector& Offset, float MaxOffset, int32 BitsPerComponent)
+{
+	check(BitsPerComponent > 0 && BitsPerComponent <= 24 && MaxOffset > 0.0f);
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		uint32 Packed = Ar.IsSaving() ? QuantizeUnitFloat(Offset[Axis] / MaxOffset, BitsPerComponent) : 0;
+		Ar.SerializeBits(&Packed, BitsPerComponent);
+
+		if (Ar.IsLoading())
+		{
+			Offset[Axis] = DequantizeUnitFloat(Packed, BitsPerComponent) * MaxOffset;
+		}
+	}
+}
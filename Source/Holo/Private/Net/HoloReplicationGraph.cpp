@@ -0,0 +1,249 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/HoloReplicationGraph.h"
+
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+#include "Weapons/HoloWeapon.h"
+
+void UHoloReplicationGraphNode_OwnerRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	const UHoloReplicationGraph* Graph = GetTypedOuter<UHoloReplicationGraph>();
+	const UNetConnection* Connection = Params.ConnectionManager.NetConnection;
+
+	ReplicationActorList.Reset();
+	for (AActor* Actor : Graph->GetOwnerRelevantActors())
+	{
+		if (Actor && Actor->GetNetConnection() == Connection)
+		{
+			ReplicationActorList.Add(Actor);
+		}
+	}
+
+	if (ReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	}
+}
+
+void UHoloReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Classes we never want to route: weapons replicate with their pawn, controllers through their own connection
+	ClassRepNodePolicies.Set(AHoloWeapon::StaticClass(), EHoloClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), EHoloClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EHoloClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(AInfo::StaticClass(), EHoloClassRepNodeMapping::RelevantAllConnections);
+
+	// Give every replicated class its cull distance and update period, the same settings the legacy driver would have used
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated() || Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists))
+		{
+			continue;
+		}
+
+		// Skip skeleton and reinstanced blueprint classes
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const EHoloClassRepNodeMapping Mapping = GetMappingPolicy(Class);
+		const bool bSpatialize = Mapping >= EHoloClassRepNodeMapping::Spatialize_Static;
+
+		FClassReplicationInfo Info;
+		InitClassReplicationInfo(Info, Class, bSpatialize);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, Info);
+	}
+
+	DestructInfoMaxDistanceSquared = FMath::Square(DestructionInfoMaxDistance);
+}
+
+void UHoloReplicationGraph::InitGlobalGraphNodes()
+{
+	// Preallocate some replication lists
+	PreAllocateRepList(3, 12);
+	PreAllocateRepList(6, 12);
+	PreAllocateRepList(128, 64);
+	PreAllocateRepList(512, 16);
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UHoloReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// The connection's own player controller and view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+
+	// Any other actor the connection owns that is only relevant to its owner
+	UHoloReplicationGraphNode_OwnerRelevant_ForConnection* OwnerRelevantNode = CreateNewNode<UHoloReplicationGraphNode_OwnerRelevant_ForConnection>();
+	AddConnectionGraphNode(OwnerRelevantNode, RepGraphConnection);
+}
+
+void UHoloReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	// Weapons follow their pawn: replicated to whoever the pawn is replicated to, right after it
+	if (AHoloWeapon* Weapon = Cast<AHoloWeapon>(ActorInfo.Actor))
+	{
+		if (AActor* WeaponOwner = Weapon->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.AddDependentActor(WeaponOwner, Weapon);
+			return;
+		}
+	}
+
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EHoloClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::RelevantToOwner:
+		OwnerRelevantActors.Add(ActorInfo.Actor);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UHoloReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (AHoloWeapon* Weapon = Cast<AHoloWeapon>(ActorInfo.Actor))
+	{
+		if (AActor* WeaponOwner = Weapon->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.RemoveDependentActor(WeaponOwner, Weapon);
+			return;
+		}
+	}
+
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EHoloClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::RelevantToOwner:
+		OwnerRelevantActors.RemoveSingleSwap(ActorInfo.Actor, false);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EHoloClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+EHoloClassRepNodeMapping UHoloReplicationGraph::GetMappingPolicy(const UClass* Class)
+{
+	// Explicit policies win, for the class or any of its parents
+	if (const EHoloClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	const EHoloClassRepNodeMapping Policy = GetDefaultMappingPolicy(Class);
+	ClassRepNodePolicies.Set(Class, Policy);
+	return Policy;
+}
+
+EHoloClassRepNodeMapping UHoloReplicationGraph::GetDefaultMappingPolicy(const UClass* Class)
+{
+	const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+	if (!ActorCDO || !ActorCDO->GetIsReplicated())
+	{
+		return EHoloClassRepNodeMapping::NotRouted;
+	}
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return EHoloClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	// Only replicated to their owner, gathered by the node of the owning connection
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EHoloClassRepNodeMapping::RelevantToOwner;
+	}
+
+	const USceneComponent* RootComponent = ActorCDO->GetRootComponent();
+	if (!RootComponent || RootComponent->Mobility == EComponentMobility::Static)
+	{
+		return EHoloClassRepNodeMapping::Spatialize_Static;
+	}
+
+	return ActorCDO->NetDormancy > DORM_Awake ? EHoloClassRepNodeMapping::Spatialize_Dormancy : EHoloClassRepNodeMapping::Spatialize_Dynamic;
+}
+
+void UHoloReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, const UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+
+	Info.ReplicationPeriodFrame = GetReplicationPeriodFrame(ActorCDO->NetUpdateFrequency);
+}
+
+uint32 UHoloReplicationGraph::GetReplicationPeriodFrame(float NetUpdateFrequency) const
+{
+	// Same update rate as the legacy driver: NetUpdateFrequency times per second
+	return FMath::Max<uint32>(FMath::RoundToFloat(NetDriver->NetServerMaxTickRate / FMath::Max(NetUpdateFrequency, KINDA_SMALL_NUMBER)), 1);
+}
+
+void UHoloReplicationGraph::NotifyNetUpdateFrequencyChanged(AActor* Actor)
+{
+	const UNetDriver* ActorNetDriver = Actor ? Actor->GetNetDriver() : nullptr;
+	UHoloReplicationGraph* Graph = ActorNetDriver ? Cast<UHoloReplicationGraph>(ActorNetDriver->GetReplicationDriver()) : nullptr;
+	if (!Graph)
+	{
+		return;
+	}
+
+	if (FGlobalActorReplicationInfo* GlobalInfo = Graph->GlobalActorReplicationInfoMap.Find(Actor))
+	{
+		GlobalInfo->Settings.ReplicationPeriodFrame = Graph->GetReplicationPeriodFrame(Actor->NetUpdateFrequency);
+	}
+}
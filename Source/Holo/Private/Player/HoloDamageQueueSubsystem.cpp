@@ -0,0 +1,93 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Player/HoloDamageQueueSubsystem.h"
+
+#include "Holo.h"
+#include "Player/HoloHealthComponent.h"
+#include "Player/HoloPawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flush Damage Queue"), STAT_HoloFlushDamage, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damaged Pawns"), STAT_HoloDamagedPawns, STATGROUP_Holo);
+
+void UHoloDamageQueueSubsystem::Deinitialize()
+{
+	QueuedDamage.Empty();
+	TargetDamage.Empty();
+	TargetIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHoloDamageQueueSubsystem::Tick(float DeltaTime)
+{
+	if (QueuedDamage.Num() > 0)
+	{
+		Auth_FlushDamage();
+	}
+}
+
+TStatId UHoloDamageQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloDamageQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloDamageQueueSubsystem::Auth_QueueDamage(AHoloPawn* Target, float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	checkf(IsServerWorld(), TEXT("UHoloDamageQueueSubsystem::Auth_QueueDamage called on client"));
+
+	FQueuedDamage& Queued = QueuedDamage.AddDefaulted_GetRef();
+	Queued.Target = Target;
+	Queued.EventInstigator = EventInstigator;
+	Queued.DamageCauser = DamageCauser;
+	Queued.DamageTypeClass = DamageEvent.DamageTypeClass;
+	Queued.Damage = Damage;
+	DamageEvent.GetBestHitInfo(Target, DamageCauser, Queued.HitInfo, Queued.ShotDirection);
+}
+
+void UHoloDamageQueueSubsystem::Auth_FlushDamage()
+{
+	checkf(IsServerWorld(), TEXT("UHoloDamageQueueSubsystem::Auth_FlushDamage called on client"));
+
+	HOLO_SCOPED_TIMING(FlushDamage);
+
+	// Sum the damage of each pawn, in the order pawns were first hit, and find the blow that kills it, if any
+	for (int32 Index = 0; Index < QueuedDamage.Num(); ++Index)
+	{
+		const FQueuedDamage& Queued = QueuedDamage[Index];
+		AHoloPawn* Target = Queued.Target.Get();
+		if (!Target || Target->bIsDying)
+		{
+			continue;
+		}
+
+		int32& TargetIndex = TargetIndices.FindOrAdd(Target, INDEX_NONE);
+		if (TargetIndex == INDEX_NONE)
+		{
+			TargetIndex = TargetDamage.Add({ Target, 0.0f, Index, false });
+		}
+
+		FTargetDamage& Damage = TargetDamage[TargetIndex];
+		Damage.TotalDamage += Queued.Damage;
+		if (!Damage.bIsLethal)
+		{
+			const UHoloHealthComponent* HealthComponent = Target->GetHealthComponent();
+			Damage.DecisiveEvent = Index;
+			Damage.bIsLethal = HealthComponent && Damage.TotalDamage >= HealthComponent->CurrentHealth;
+		}
+	}
+
+	// Apply it: health, death and feedback only ever see the sum, along with the decisive event
+	for (const FTargetDamage& Damage : TargetDamage)
+	{
+		const FQueuedDamage& Decisive = QueuedDamage[Damage.DecisiveEvent];
+		const FPointDamageEvent DamageEvent(Decisive.Damage, Decisive.HitInfo, Decisive.ShotDirection, Decisive.DamageTypeClass);
+		Damage.Target->Auth_ApplyQueuedDamage(Damage.TotalDamage, DamageEvent, Decisive.EventInstigator.Get(), Decisive.DamageCauser.Get());
+	}
+
+	HOLO_INC_COUNTER(DamagedPawns, TargetDamage.Num());
+
+	QueuedDamage.Reset();
+	TargetDamage.Reset();
+	TargetIndices.Reset();
+}
@@ -3,9 +3,12 @@
 
 #include "Player/HoloHealthComponent.h"
 
+#include "Holo.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
 #include "Player/HoloPawn.h"
 
+DECLARE_CYCLE_STAT(TEXT("Apply Damage"), STAT_HoloApplyDamage, STATGROUP_Holo);
 
 // Sets default values for this component's properties
 UHoloHealthComponent::UHoloHealthComponent()
@@ -26,7 +29,10 @@ void UHoloHealthComponent::BeginPlay()
 
 float UHoloHealthComponent::ApplyDamage(float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	HOLO_SCOPED_TIMING(ApplyDamage);
+
 	CurrentHealth = FMath::Max<float>(CurrentHealth - Damage, 0.0f);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UHoloHealthComponent, CurrentHealth, this);
 	OnRep_CurrentHealth();
 	
 	if (CurrentHealth <= 0.0f)
@@ -42,6 +48,15 @@ float UHoloHealthComponent::ApplyDamage(float Damage, FDamageEvent const& Damage
 	return Damage;
 }
 
+void UHoloHealthComponent::Auth_ResetHealth()
+{
+	checkf(GetOwner()->HasAuthority(), TEXT("UHoloHealthComponent::Auth_ResetHealth called on client"));
+
+	CurrentHealth = MaxHealth;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UHoloHealthComponent, CurrentHealth, this);
+	OnRep_CurrentHealth();
+}
+
 void UHoloHealthComponent::OnRep_CurrentHealth()
 {
 	if (OnHealthChangedDelegate.IsBound())
@@ -54,7 +69,9 @@ void UHoloHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(UHoloHealthComponent, CurrentHealth);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHoloHealthComponent, CurrentHealth, Params);
 }
 
 
@@ -3,16 +3,47 @@
 
 #include "Player/HoloPawn.h"
 
+#include "Holo.h"
 #include "Blueprint/UserWidget.h"
 #include "Components/CapsuleComponent.h"
+#include "Core/HoloAssetPreloadSubsystem.h"
 #include "Core/HoloGameMode.h"
+#include "Core/HoloGameState.h"
+#include "EngineUtils.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/HoloLagCompensationSubsystem.h"
+#include "Net/HoloReplicationGraph.h"
 #include "Net/UnrealNetwork.h"
+#include "Player/HoloDamageQueueSubsystem.h"
 #include "Player/HoloHealthComponent.h"
 #include "Player/HoloPlayerController.h"
 #include "UI/HoloGameLayoutWidget.h"
+#include "Weapons/HoloAreaDamageSubsystem.h"
 #include "Weapons/HoloWeapon.h"
 
+DECLARE_CYCLE_STAT(TEXT("Pawn Take Damage"), STAT_HoloTakeDamage, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_HoloDamageEvents, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pawns In Combat"), STAT_HoloPawnsInCombat, STATGROUP_Holo);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Pawn Net Update Rate (Hz)"), STAT_HoloPawnNetUpdateRate, STATGROUP_Holo);
+
+static FAutoConsoleCommandWithWorld DumpNetUpdateRatesCommand(
+	TEXT("Holo.Net.DumpUpdateRates"),
+	TEXT("Logs the current adaptive network update rate of every pawn of the server world."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			return;
+		}
+
+		for (TActorIterator<AHoloPawn> It(World); It; ++It)
+		{
+			const AHoloPawn* Pawn = *It;
+			UE_LOG(LogHolo, Log, TEXT("%s: %.1f Hz, %.2fs since combat"), *Pawn->GetName(), Pawn->NetUpdateFrequency, Pawn->GetTimeSinceCombatActivity());
+		}
+	}));
 
 // Sets default values
 AHoloPawn::AHoloPawn()
@@ -40,6 +71,21 @@ AHoloPawn::AHoloPawn()
 
 	HealthComponent = CreateDefaultSubobject<UHoloHealthComponent>(TEXT("HealthComponent"));
 	HealthComponent->SetIsReplicated(true);
+
+	DamageCameraShakeFullScaleDamage = 30.0f;
+
+	// Idle pawns replicate slowly, combat speeds them up, see Auth_NotifyCombatActivity
+	IdleNetUpdateFrequency = 15.0f;
+	CombatNetUpdateFrequency = 60.0f;
+	CombatActivityHoldTime = 1.0f;
+	CombatActivityDecayTime = 2.0f;
+	NetUpdateFrequency = IdleNetUpdateFrequency;
+	LastCombatActivityTime = TNumericLimits<float>::Lowest();
+
+	NearPriorityDistance = 2000.0f;
+	NearPriorityScale = 2.0f;
+	AimConeHalfAngle = 15.0f;
+	AimConePriorityScale = 3.0f;
 }
 
 // Called when the game starts or when spawned
@@ -49,45 +95,178 @@ void AHoloPawn::BeginPlay()
 
 	if (HasAuthority())
 	{
-		// Spawn default weapon
-		checkf(DefaultWeaponClass, TEXT("DefaultWeaponClass is not set"));
-		Auth_SpawnWeapon(DefaultWeaponClass);
+		// Spawn default weapon, normally preloaded by now: this only blocks if the pawn spawned before it streamed in
+		checkf(!DefaultWeaponClass.IsNull(), TEXT("DefaultWeaponClass is not set"));
+		Auth_SpawnWeapon(DefaultWeaponClass.LoadSynchronous());
+
+		// Record our position history so shots can be validated against what the shooter saw
+		if (UHoloLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UHoloLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterPawn(this);
+		}
+		// Living pawns are bucketed for area of effect damage
+		if (UHoloAreaDamageSubsystem* AreaDamage = GetWorld()->GetSubsystem<UHoloAreaDamageSubsystem>())
+		{
+			AreaDamage->RegisterPawn(this);
+		}
 	}
 
-	if (IsLocallyControlled())
+	CreateGameLayoutWidget();
+}
+
+void AHoloPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UHoloLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UHoloLagCompensationSubsystem>())
 	{
-		checkf(GameLayoutWidgetClass, TEXT("GameLayoutWidgetClass is not set!"));
+		LagCompensation->UnregisterPawn(this);
+	}
 
-		GameLayoutWidget = CreateWidget<UHoloGameLayoutWidget>(GetGameInstance(), GameLayoutWidgetClass);
-		GameLayoutWidget->AddToViewport();
+	if (UHoloAreaDamageSubsystem* AreaDamage = GetWorld()->GetSubsystem<UHoloAreaDamageSubsystem>())
+	{
+		AreaDamage->UnregisterPawn(this);
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AHoloPawn::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
-	// Create a dynamic material instance so we can change the color of our pawn on the fly.
 	USkeletalMeshComponent* MeshComponent = GetMesh();
 	if (MeshComponent)
 	{
-		MeshMID = MeshComponent->CreateDynamicMaterialInstance(0);
+		MeshCollisionProfileName = MeshComponent->GetCollisionProfileName();
+
+#if WITH_HOLO_COSMETICS
+		if (Holo::ShouldPlayCosmetics(this))
+		{
+			// Create a dynamic material instance so we can change the color of our pawn on the fly.
+			MeshMID = MeshComponent->CreateDynamicMaterialInstance(0);
+		}
+		else
+#endif
+		{
+			// Nobody will ever render this mesh, don't animate it either
+			MeshComponent->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		}
+	}
+}
+
+void AHoloPawn::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	// The new controller's fire commands start over from sequence 0, possibly on another connection for a pooled pawn
+	if (Weapon)
+	{
+		Weapon->ResetFireCommandStream();
+	}
+}
+
+void AHoloPawn::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	// Matches the reset done by the server in PossessedBy
+	if (Weapon)
+	{
+		Weapon->ResetFireCommandStream();
+	}
+
+	// A pooled pawn may have been handed over to a new local player
+	CreateGameLayoutWidget();
+}
+
+void AHoloPawn::CreateGameLayoutWidget()
+{
+	if (GameLayoutWidget || !IsLocallyControlled())
+	{
+		return;
+	}
+
+	checkf(!GameLayoutWidgetClass.IsNull(), TEXT("GameLayoutWidgetClass is not set!"));
+
+	// Wait for the class to stream in rather than hitching, should the pawn be ready before the preload is done
+	if (!GameLayoutWidgetClass.Get())
+	{
+		if (UHoloAssetPreloadSubsystem* Preload = GetWorld()->GetSubsystem<UHoloAssetPreloadSubsystem>())
+		{
+			// Loads synchronously as a last resort if the request failed, rather than requesting it again
+			Preload->RequestPreload({ GameLayoutWidgetClass.ToSoftObjectPath() }, FSimpleDelegate::CreateWeakLambda(this, [this]()
+			{
+				GameLayoutWidgetClass.LoadSynchronous();
+				CreateGameLayoutWidget();
+			}));
+			return;
+		}
+		GameLayoutWidgetClass.LoadSynchronous();
+	}
+
+	GameLayoutWidget = CreateWidget<UHoloGameLayoutWidget>(GetGameInstance(), GameLayoutWidgetClass.Get());
+	GameLayoutWidget->AddToViewport();
+}
+
+void AHoloPawn::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets, bool bCosmetics) const
+{
+	if (!DefaultWeaponClass.IsNull())
+	{
+		OutAssets.AddUnique(DefaultWeaponClass.ToSoftObjectPath());
+	}
+	if (bCosmetics && !GameLayoutWidgetClass.IsNull())
+	{
+		OutAssets.AddUnique(GameLayoutWidgetClass.ToSoftObjectPath());
 	}
 }
 
 float AHoloPawn::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
-	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
-	if (ActualDamage > 0.0f && HealthComponent)
+	// Dead pawns are dormant, their health wouldn't replicate anyway
+	if (bIsDying)
 	{
-		HealthComponent->ApplyDamage(ActualDamage, DamageEvent, EventInstigator, DamageCauser);
+		return 0.0f;
 	}
 
-	Client_SimulateDamage();
+	HOLO_SCOPED_TIMING(TakeDamage);
+	HOLO_INC_COUNTER(DamageEvents, 1);
+
+	// Health, death and feedback are resolved once per frame with the rest of the damage taken, see UHoloDamageQueueSubsystem
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	if (ActualDamage > 0.0f)
+	{
+		UHoloDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UHoloDamageQueueSubsystem>();
+		if (DamageQueue)
+		{
+			DamageQueue->Auth_QueueDamage(this, ActualDamage, DamageEvent, EventInstigator, DamageCauser);
+		}
+		else
+		{
+			Auth_ApplyQueuedDamage(ActualDamage, DamageEvent, EventInstigator, DamageCauser);
+		}
+	}
 
 	return ActualDamage;
 }
 
+void AHoloPawn::Auth_ApplyQueuedDamage(float TotalDamage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	checkf(HasAuthority(), TEXT("AHoloPawn::Auth_ApplyQueuedDamage called on client"));
+
+	if (bIsDying)
+	{
+		return;
+	}
+
+	if (HealthComponent)
+	{
+		HealthComponent->ApplyDamage(TotalDamage, DamageEvent, EventInstigator, DamageCauser);
+	}
+
+	Auth_NotifyCombatActivity();
+
+	Client_SimulateDamage(TotalDamage);
+}
+
 void AHoloPawn::OnRep_Color()
 {
 	if (MeshMID)
@@ -107,7 +286,24 @@ void AHoloPawn::OnRep_Weapon()
 	if (Weapon)
 	{
 		Weapon->AttachToComponent(WeaponHandle, FAttachmentTransformRules::SnapToTargetIncludingScale);
-		Weapon->AddTickPrerequisiteActor(this);
+	}
+
+	OnWeaponChangedDelegate.Broadcast(Weapon);
+}
+
+void AHoloPawn::ApplyBotInput(float MoveForward, float MoveRight, float MoveUp, bool bFire)
+{
+	OnMoveForward(MoveForward);
+	OnMoveRight(MoveRight);
+	OnMoveUp(MoveUp);
+
+	if (bFire)
+	{
+		OnFire();
+	}
+	else
+	{
+		OnStopFire();
 	}
 }
 
@@ -115,7 +311,15 @@ void AHoloPawn::OnFire()
 {
 	if (Weapon && !bIsDying)
 	{
-		Weapon->HandleFireInput();
+		Weapon->StartFire();
+	}
+}
+
+void AHoloPawn::OnStopFire()
+{
+	if (Weapon)
+	{
+		Weapon->StopFire();
 	}
 }
 
@@ -178,11 +382,20 @@ void AHoloPawn::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (HasAuthority())
+	{
+		Auth_UpdateNetUpdateFrequency();
+
+		// Accounted here only, as combat activity also updates the rate in between frames
+		HOLO_INC_COUNTER(PawnsInCombat, GetTimeSinceCombatActivity() < CombatActivityHoldTime + CombatActivityDecayTime ? 1 : 0);
+		INC_FLOAT_STAT_BY(STAT_HoloPawnNetUpdateRate, NetUpdateFrequency);
+	}
+
 	// Update weapon aim location
 	if (Weapon)
 	{
-		FVector ViewLocation = GetPawnViewLocation();
-		FTransform ViewTransform = GetMesh() ? GetMesh()->GetComponentTransform() : GetActorTransform();
+		const FVector ViewLocation = GetPawnViewLocation();
+		const FTransform ViewTransform = GetMesh() ? GetMesh()->GetComponentTransform() : GetActorTransform();
 		Weapon->UpdateAimLocation(ViewLocation, ViewTransform);
 	}
 }
@@ -194,6 +407,7 @@ void AHoloPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 
 	// Bind weapon actions
 	PlayerInputComponent->BindAction(TEXT("Fire"), IE_Pressed, this, &AHoloPawn::OnFire);
+	PlayerInputComponent->BindAction(TEXT("Fire"), IE_Released, this, &AHoloPawn::OnStopFire);
 
 	// Bind movement inputs (mostly parroted from DefaultPawn.cpp)
 	PlayerInputComponent->BindAxis(TEXT("MoveForward"), this, &AHoloPawn::OnMoveForward);
@@ -210,6 +424,7 @@ void AHoloPawn::Auth_SetColor(const FLinearColor& InColor)
 	checkf(HasAuthority(), TEXT("AHoloPawn::Auth_SetColor called on client"));
 
 	Color = InColor;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHoloPawn, Color, this);
 
 	OnRep_Color();
 }
@@ -231,6 +446,14 @@ void AHoloPawn::Auth_SpawnWeapon(TSubclassOf<AHoloWeapon> WeaponClass)
 	const FVector SpawnLocation = WeaponHandle->GetComponentLocation();
 	const FRotator SpawnRotation = WeaponHandle->GetComponentRotation();
 	Weapon = GetWorld()->SpawnActor<AHoloWeapon>(WeaponClass, SpawnLocation, SpawnRotation, SpawnInfo);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHoloPawn, Weapon, this);
+
+	// The weapon replicates at the same adaptive rate as its pawn
+	if (Weapon)
+	{
+		Weapon->NetUpdateFrequency = NetUpdateFrequency;
+		UHoloReplicationGraph::NotifyNetUpdateFrequencyChanged(Weapon);
+	}
 
 	OnRep_Weapon();
 }
@@ -243,6 +466,11 @@ bool AHoloPawn::Die(float KillingDamage, FDamageEvent const& DamageEvent, AContr
 		return false;
 	}
 
+	if (AHoloGameState* GameState = GetWorld()->GetGameState<AHoloGameState>())
+	{
+		GameState->Auth_NotifyKill(Killer ? Killer->GetPlayerState<APlayerState>() : nullptr, GetPlayerState());
+	}
+
 	OnDeath(KillingDamage, DamageEvent, Killer ? Killer->GetPawn() : nullptr, DamageCauser);
 
 	return true;
@@ -263,40 +491,227 @@ bool AHoloPawn::CanDie(float KillingDamage, FDamageEvent const& DamageEvent, ACo
 
 void AHoloPawn::OnRep_IsDying()
 {
+	if (!bIsDying)
+	{
+		// Respawned through the pool
+		ResetDeathState();
+		OnRespawnedDelegate.Broadcast();
+		return;
+	}
+
+	OnDyingDelegate.Broadcast();
+
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	
 	if (Weapon)
 	{
-		Weapon->SetActorTickEnabled(false);
+		Weapon->SetRotationUpdatesEnabled(false);
 	}
 
+#if WITH_HOLO_COSMETICS
 	// visual effects
-	SetRagdollPhysics();
-	GetMesh()->AddTorqueInRadians(FVector(10000000.0));
+	if (Holo::ShouldPlayCosmetics(this))
+	{
+		SetRagdollPhysics();
+		GetMesh()->AddTorqueInRadians(FVector(10000000.0));
+
+		if (DeathCameraShake)
+		{
+			PlayCameraShake(DeathCameraShake);
+		}
+	}
+#endif
+}
 
-	if (DeathCameraShake)
+void AHoloPawn::ResetDeathState()
+{
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+
+	if (Weapon)
+	{
+		Weapon->SetRotationUpdatesEnabled(true);
+	}
+
+	// Leave ragdoll and put the mesh back where it belongs on the capsule
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (MeshComponent && Holo::ShouldPlayCosmetics(this))
 	{
-		PlayCameraShake(DeathCameraShake);
+		MeshComponent->SetSimulatePhysics(false);
+		MeshComponent->bBlendPhysics = false;
+		MeshComponent->SetCollisionProfileName(MeshCollisionProfileName);
+		MeshComponent->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+		MeshComponent->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
 	}
+
+	UCharacterMovementComponent* MoveComponent = GetCharacterMovement();
+	MoveComponent->SetComponentTickEnabled(true);
+	MoveComponent->StopMovementImmediately();
+	MoveComponent->SetMovementMode(MoveComponent->DefaultLandMovementMode);
 }
 
 void AHoloPawn::RestartPlayer()
 {
-	AHoloPlayerController* PC = CastChecked<AHoloPlayerController>(GetController());
+	// Our player may have left while we were dying
+	AHoloPlayerController* PC = Cast<AHoloPlayerController>(GetController());
+	if (PC)
+	{
+		PC->Respawn();
+	}
+}
+
+void AHoloPawn::Auth_ResetForRespawn(const FVector& Location, const FRotator& Rotation)
+{
+	checkf(HasAuthority(), TEXT("AHoloPawn::Auth_ResetForRespawn called on client"));
+
+	GetWorldTimerManager().ClearTimer(TimerHandle_Restart);
+
+	// We've been dormant since we died or were pooled
+	SetNetDormancy(DORM_Awake);
+
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
 
 	if (Weapon)
 	{
-		Weapon->Destroy();
+		Weapon->FlushNetDormancy();
+		Weapon->SetActorHiddenInGame(false);
 	}
-	
-	Destroy();
-	
-	PC->Respawn();
+
+	HealthComponent->Auth_ResetHealth();
+
+	bIsDying = false;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHoloPawn, bIsDying, this);
+	OnRep_IsDying();
+
+	// Don't let shots rewind us back to where we died
+	if (UHoloLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UHoloLagCompensationSubsystem>())
+	{
+		LagCompensation->RegisterPawn(this);
+		LagCompensation->ResetPawnHistory(this);
+	}
+
+	if (UHoloAreaDamageSubsystem* AreaDamage = GetWorld()->GetSubsystem<UHoloAreaDamageSubsystem>())
+	{
+		AreaDamage->RegisterPawn(this);
+	}
+
+	ForceNetUpdate();
+}
+
+void AHoloPawn::Auth_Deactivate()
+{
+	checkf(HasAuthority(), TEXT("AHoloPawn::Auth_Deactivate called on client"));
+
+	GetWorldTimerManager().ClearTimer(TimerHandle_Restart);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	if (Weapon)
+	{
+		Weapon->FlushNetDormancy();
+		Weapon->SetActorHiddenInGame(true);
+		Weapon->SetRotationUpdatesEnabled(false);
+	}
+
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (MeshComponent)
+	{
+		MeshComponent->SetSimulatePhysics(false);
+	}
+
+	UCharacterMovementComponent* MoveComponent = GetCharacterMovement();
+	MoveComponent->StopMovementImmediately();
+	MoveComponent->DisableMovement();
+	MoveComponent->SetComponentTickEnabled(false);
+
+	if (UHoloLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UHoloLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterPawn(this);
+	}
+
+	if (UHoloAreaDamageSubsystem* AreaDamage = GetWorld()->GetSubsystem<UHoloAreaDamageSubsystem>())
+	{
+		AreaDamage->UnregisterPawn(this);
+	}
+
+	// Pooled pawns don't change until they're reused: go dormant once they've been hidden on every client
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AHoloPawn::Auth_NotifyCombatActivity()
+{
+	checkf(HasAuthority(), TEXT("AHoloPawn::Auth_NotifyCombatActivity called on client"));
+
+	LastCombatActivityTime = GetWorld()->GetTimeSeconds();
+	Auth_UpdateNetUpdateFrequency();
+}
+
+float AHoloPawn::GetTimeSinceCombatActivity() const
+{
+	return GetWorld()->GetTimeSeconds() - LastCombatActivityTime;
+}
+
+void AHoloPawn::Auth_UpdateNetUpdateFrequency()
+{
+	const float DecayTime = GetTimeSinceCombatActivity() - CombatActivityHoldTime;
+	const float DecayAlpha = CombatActivityDecayTime > 0.0f ? FMath::Clamp(DecayTime / CombatActivityDecayTime, 0.0f, 1.0f) : (DecayTime > 0.0f ? 1.0f : 0.0f);
+
+	// Whole Hz steps, so the replication graph is only told about the rate a few times per decay
+	const float NewFrequency = FMath::RoundToFloat(FMath::Lerp(CombatNetUpdateFrequency, IdleNetUpdateFrequency, DecayAlpha));
+	if (NewFrequency == NetUpdateFrequency)
+	{
+		return;
+	}
+
+	NetUpdateFrequency = NewFrequency;
+	UHoloReplicationGraph::NotifyNetUpdateFrequencyChanged(this);
+
+	if (Weapon)
+	{
+		Weapon->NetUpdateFrequency = NewFrequency;
+		UHoloReplicationGraph::NotifyNetUpdateFrequencyChanged(Weapon);
+	}
+}
+
+float AHoloPawn::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	// The viewer's own pawn is already boosted by APawn
+	if (ViewTarget == this || (Controller && Controller == Viewer))
+	{
+		return Priority;
+	}
+
+	const FVector ToPawn = GetActorLocation() - ViewPos;
+	const float DistanceSquared = ToPawn.SizeSquared();
+	if (DistanceSquared < FMath::Square(NearPriorityDistance))
+	{
+		Priority *= NearPriorityScale;
+	}
+
+	// Favor whoever the viewer is aiming at, falling back to the view direction when the viewer has no valid aim
+	const AHoloPawn* ViewerPawn = Cast<AHoloPawn>(ViewTarget);
+	const AHoloWeapon* ViewerWeapon = ViewerPawn ? ViewerPawn->GetWeapon() : nullptr;
+	const FVector AimDirection = ViewerWeapon && ViewerWeapon->IsAimLocationValid() ? (ViewerWeapon->GetAimLocation() - ViewPos).GetSafeNormal() : ViewDir;
+	const float CosAimCone = FMath::Cos(FMath::DegreesToRadians(AimConeHalfAngle));
+	const float AimDot = FVector::DotProduct(ToPawn, AimDirection);
+	if (AimDot > 0.0f && FMath::Square(AimDot) >= DistanceSquared * FMath::Square(CosAimCone))
+	{
+		Priority *= AimConePriorityScale;
+	}
+
+	return Priority;
 }
 
 void AHoloPawn::OnDeath(float KillingDamage, FDamageEvent const& DamageEvent, APawn* InstigatingPawn, AActor* DamageCauser)
 {
 	bIsDying = true;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHoloPawn, bIsDying, this);
 	OnRep_IsDying();
 
 	UCharacterMovementComponent* MoveComponent = GetCharacterMovement();
@@ -304,8 +719,10 @@ void AHoloPawn::OnDeath(float KillingDamage, FDamageEvent const& DamageEvent, AP
 	MoveComponent->DisableMovement();
 	MoveComponent->SetComponentTickEnabled(false);
 	
-	FTimerHandle TimerHandle_Restart;
 	GetWorldTimerManager().SetTimer(TimerHandle_Restart, this, &AHoloPawn::RestartPlayer, 3.0f, false);
+
+	// Nothing changes while we wait to respawn: stop considering us for replication once our death has been sent
+	SetNetDormancy(DORM_DormantAll);
 }
 
 void AHoloPawn::SetRagdollPhysics()
@@ -324,26 +741,40 @@ void AHoloPawn::SetRagdollPhysics()
 	GetMesh()->SetCollisionProfileName(CollisionProfileName);
 }
 
-void AHoloPawn::PlayCameraShake(TSubclassOf<UCameraShakeBase> CameraShake) const
+void AHoloPawn::PlayCameraShake(TSubclassOf<UCameraShakeBase> CameraShake, float Scale) const
 {
 	AHoloPlayerController* PC = Cast<AHoloPlayerController>(GetController());
 	if (PC && PC->IsLocalController())
 	{
-		PC->ClientStartCameraShake(CameraShake, 1);
+		PC->ClientStartCameraShake(CameraShake, Scale);
 	}
 }
 
-void AHoloPawn::Client_SimulateDamage_Implementation()
+void AHoloPawn::Client_SimulateDamage_Implementation(float Damage)
+{
+	const float Scale = DamageCameraShakeFullScaleDamage > 0.0f ? FMath::Clamp(Damage / DamageCameraShakeFullScaleDamage, 0.25f, 1.0f) : 1.0f;
+	PlayCameraShake(DamageCameraShake, Scale);
+}
+
+void AHoloPawn::Multicast_SpawnProjectile_Implementation(const FHoloProjectileSpawn& Spawn)
 {
-	PlayCameraShake(DamageCameraShake);
+	if (HasAuthority() || IsLocallyControlled() || !Weapon)
+	{
+		return;
+	}
+
+	Weapon->OnProjectileSpawnReceived(Spawn);
 }
 
 void AHoloPawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AHoloPawn, Weapon);
-	DOREPLIFETIME(AHoloPawn, Color);
-	DOREPLIFETIME(AHoloPawn, bIsDying);
+	// These rarely change: they're marked dirty when they do, instead of being compared every update
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHoloPawn, Weapon, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHoloPawn, Color, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHoloPawn, bIsDying, Params);
 }
 
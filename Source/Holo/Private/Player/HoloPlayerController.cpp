@@ -3,9 +3,158 @@
 
 #include "Player/HoloPlayerController.h"
 
+#include "Holo.h"
+#include "Core/HoloGameMode.h"
+#include "EngineUtils.h"
 #include "GameFramework/GameModeBase.h"
+#include "Net/HoloFireValidationSubsystem.h"
+#include "Player/HoloPawn.h"
+#include "Weapons/HoloWeapon.h"
+
+DECLARE_CYCLE_STAT(TEXT("Receive Fire Commands"), STAT_HoloReceiveFireCommands, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Bot Update"), STAT_HoloUpdateBot, STATGROUP_Holo);
+
+AHoloPlayerController::AHoloPlayerController()
+{
+	BotEngageDistance = 4000.0f;
+	BotFireConeHalfAngle = 5.0f;
+	BotAimInterpSpeed = 5.0f;
+	bIsBot = false;
+	BotWanderLocation = FVector::ZeroVector;
+	BotNextWanderTime = 0.0f;
+}
+
+void AHoloPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	bIsBot = IsLocalController() && FParse::Param(FCommandLine::Get(), TEXT("HoloBot"));
+}
+
+void AHoloPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+
+	if (bIsBot)
+	{
+		UpdateBot(DeltaTime);
+	}
+
+	// Input has been processed: fire the shots due this frame, and send them to the server in a single packet
+	AHoloWeapon* Weapon = GetPawnWeapon();
+	if (Weapon)
+	{
+		Weapon->UpdateFiring();
+	}
+
+	FHoloFireCommandPacket Packet;
+	if (Weapon && Weapon->FlushFireCommands(Packet))
+	{
+		Server_SendFireCommands(Packet);
+	}
+}
+
+void AHoloPlayerController::PawnLeavingGame()
+{
+	// Hand our pawn over to the pool instead of destroying it, so that the next player joining can reuse it
+	AHoloGameMode* GameMode = GetWorld()->GetAuthGameMode<AHoloGameMode>();
+	AHoloPawn* HoloPawn = GetPawn<AHoloPawn>();
+	if (GameMode && HoloPawn && GameMode->Auth_ReleasePawn(HoloPawn))
+	{
+		UnPossess();
+		SetPawn(nullptr);
+		return;
+	}
+
+	Super::PawnLeavingGame();
+}
 
 void AHoloPlayerController::Respawn()
 {
 	GetWorld()->GetAuthGameMode()->RestartPlayer(this);
 }
+
+void AHoloPlayerController::Server_SendFireCommands_Implementation(const FHoloFireCommandPacket& Packet)
+{
+	HOLO_SCOPED_TIMING(ReceiveFireCommands);
+
+	// Drop packets beyond the client's rate limit before doing any work for them
+	UHoloFireValidationSubsystem* FireValidation = GetWorld()->GetSubsystem<UHoloFireValidationSubsystem>();
+	if (FireValidation && !FireValidation->Auth_ValidatePacket(this, Packet.Commands.Num()))
+	{
+		return;
+	}
+
+	AHoloWeapon* Weapon = GetPawnWeapon();
+	FHoloFireAck Ack;
+	if (Weapon && Weapon->Auth_ReceiveFireCommands(Packet, Ack))
+	{
+		Client_AckFireCommands(Ack);
+	}
+}
+
+void AHoloPlayerController::Client_AckFireCommands_Implementation(const FHoloFireAck& Ack)
+{
+	if (AHoloWeapon* Weapon = GetPawnWeapon())
+	{
+		Weapon->AcknowledgeFireCommands(Ack);
+	}
+}
+
+void AHoloPlayerController::UpdateBot(float DeltaTime)
+{
+	HOLO_SCOPED_TIMING(UpdateBot);
+
+	AHoloPawn* HoloPawn = GetPawn<AHoloPawn>();
+	if (!HoloPawn || HoloPawn->bIsDying)
+	{
+		return;
+	}
+
+	// Wander toward a random point, picking a new one every few seconds or once we get there
+	const FVector Location = HoloPawn->GetActorLocation();
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	if (CurrentTime >= BotNextWanderTime || FVector::DistSquared(Location, BotWanderLocation) < FMath::Square(300.0f))
+	{
+		BotWanderLocation = Location + FMath::VRand() * FMath::FRandRange(1000.0f, 4000.0f);
+		BotNextWanderTime = CurrentTime + FMath::FRandRange(2.0f, 5.0f);
+	}
+
+	// Engage the closest living enemy
+	const AHoloPawn* Target = nullptr;
+	float TargetDistanceSquared = FMath::Square(BotEngageDistance);
+	for (TActorIterator<AHoloPawn> It(GetWorld()); It; ++It)
+	{
+		const AHoloPawn* Other = *It;
+		const float DistanceSquared = FVector::DistSquared(Location, Other->GetActorLocation());
+		if (Other != HoloPawn && !Other->bIsDying && !Other->IsHidden() && DistanceSquared < TargetDistanceSquared)
+		{
+			Target = Other;
+			TargetDistanceSquared = DistanceSquared;
+		}
+	}
+
+	const FVector ViewLocation = HoloPawn->GetPawnViewLocation();
+	const FVector LookAtLocation = Target ? Target->GetActorLocation() : BotWanderLocation;
+	const FRotator DesiredRotation = (LookAtLocation - ViewLocation).Rotation();
+	SetControlRotation(FMath::RInterpTo(GetControlRotation(), DesiredRotation, DeltaTime, BotAimInterpSpeed));
+
+	// Move through the regular input handlers, which are relative to our view
+	const FRotationMatrix ViewMatrix(GetControlRotation());
+	const FVector ViewForward = ViewMatrix.GetScaledAxis(EAxis::X);
+	const FVector WanderDirection = (BotWanderLocation - Location).GetSafeNormal();
+	const FVector TargetDirection = Target ? (Target->GetActorLocation() - ViewLocation).GetSafeNormal() : FVector::ZeroVector;
+	const bool bFire = Target && FVector::DotProduct(ViewForward, TargetDirection) >= FMath::Cos(FMath::DegreesToRadians(BotFireConeHalfAngle));
+
+	HoloPawn->ApplyBotInput(
+		FVector::DotProduct(WanderDirection, ViewForward),
+		FVector::DotProduct(WanderDirection, ViewMatrix.GetScaledAxis(EAxis::Y)),
+		WanderDirection.Z,
+		bFire);
+}
+
+AHoloWeapon* AHoloPlayerController::GetPawnWeapon() const
+{
+	const AHoloPawn* HoloPawn = GetPawn<AHoloPawn>();
+	return HoloPawn ? HoloPawn->GetWeapon() : nullptr;
+}
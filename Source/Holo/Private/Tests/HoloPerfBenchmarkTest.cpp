@@ -0,0 +1,313 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Holo.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Player/HoloDamageQueueSubsystem.h"
+#include "Player/HoloHealthComponent.h"
+#include "Player/HoloPawn.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Weapons/HoloAreaDamageSubsystem.h"
+#include "Weapons/HoloWeapon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HoloPerfBenchmark
+{
+	static const TCHAR* WorldTickSection = TEXT("WorldTick");
+	static const TCHAR* FireSection = TEXT("Fire");
+	static const TCHAR* DamageSection = TEXT("Damage");
+	static const TCHAR* ExplosionsSection = TEXT("Explosions");
+
+	/** Fixed simulation step, so every run ticks the exact same amount of game time. */
+	static constexpr float FrameDeltaTime = 1.0f / 60.0f;
+
+	/** Radius of the circle pawns are spawned on. */
+	static constexpr float SpawnRadius = 1500.0f;
+
+	/** Large enough that pawns never die from the benchmark's damage between two health resets. */
+	static constexpr float BenchmarkMaxHealth = 1.0e6f;
+
+	/** Explosions are spread over the ring of pawns, each catching a fraction of them. */
+	static const FRadialDamageParams ExplosionParams(1.0f, 200.0f, 800.0f, 1.0f);
+
+	static double GetMedian(TArray<double>& Samples)
+	{
+		if (Samples.Num() == 0)
+		{
+			return 0.0;
+		}
+
+		Samples.Sort();
+		return Samples[Samples.Num() / 2];
+	}
+
+	/** Spawns the pawns evenly on a circle, looking at its center. */
+	static void SpawnPawns(UWorld* World, UClass* PawnClass, int32 NumPawns, TArray<AHoloPawn*>& OutPawns)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 Index = 0; Index < NumPawns; ++Index)
+		{
+			const float Angle = 2.0f * PI * Index / NumPawns;
+			const FVector Location(FMath::Cos(Angle) * SpawnRadius, FMath::Sin(Angle) * SpawnRadius, 0.0f);
+			const FRotator Rotation = (-Location).Rotation();
+
+			AHoloPawn* Pawn = World->SpawnActor<AHoloPawn>(PawnClass, Location, Rotation, SpawnInfo);
+			if (!Pawn)
+			{
+				continue;
+			}
+
+			if (UHoloHealthComponent* HealthComponent = Pawn->GetHealthComponent())
+			{
+				HealthComponent->MaxHealth = BenchmarkMaxHealth;
+				HealthComponent->Auth_ResetHealth();
+			}
+
+			OutPawns.Add(Pawn);
+		}
+	}
+
+	/**
+	 * Runs the benchmark and returns the median cost of each measured section, in milliseconds per frame.
+	 * Fire is the median over the frames where shots were fired only.
+	 */
+	static TMap<FString, double> RunBenchmark(UWorld* World, const TArray<AHoloPawn*>& Pawns, int32 NumExplosions, int32 NumWarmupFrames, int32 NumFrames)
+	{
+		TArray<double> WorldTickTimes;
+		TArray<double> FireTimes;
+		TArray<double> DamageTimes;
+		TArray<double> ExplosionTimes;
+
+		UHoloAreaDamageSubsystem* AreaDamage = World->GetSubsystem<UHoloAreaDamageSubsystem>();
+
+		// Weapons only fire once off cooldown: fire costs are only sampled on frames with shots, or they'd measure idle frames
+		int32 NumShotsThisFrame = 0;
+		TArray<TPair<AHoloWeapon*, FDelegateHandle>> ShotFiredHandles;
+		for (AHoloPawn* Pawn : Pawns)
+		{
+			if (AHoloWeapon* Weapon = Pawn->GetWeapon())
+			{
+				ShotFiredHandles.Emplace(Weapon, Weapon->OnShotFiredDelegate.AddLambda([&NumShotsThisFrame]() { ++NumShotsThisFrame; }));
+			}
+		}
+
+		for (int32 Frame = -NumWarmupFrames; Frame < NumFrames; ++Frame)
+		{
+			// Pawn, weapon and subsystem ticks
+			const uint64 WorldTickStart = FPlatformTime::Cycles64();
+			World->Tick(LEVELTICK_All, FrameDeltaTime);
+			const uint64 WorldTickEnd = FPlatformTime::Cycles64();
+
+			// Fire traces, lag compensation and the damage of the shots, whenever weapons are off cooldown
+			NumShotsThisFrame = 0;
+			for (AHoloPawn* Pawn : Pawns)
+			{
+				if (AHoloWeapon* Weapon = Pawn->GetWeapon())
+				{
+					Weapon->StartFire();
+					Weapon->UpdateFiring();
+				}
+			}
+			const uint64 FireEnd = FPlatformTime::Cycles64();
+
+			// Damage processing alone: every pawn is hit by its neighbor, then the frame's damage queue is resolved
+			for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+			{
+				AHoloPawn* Pawn = Pawns[Index];
+				AHoloPawn* Instigator = Pawns[(Index + 1) % Pawns.Num()];
+				FHitResult Hit(Pawn, nullptr, Pawn->GetActorLocation(), Instigator->GetActorForwardVector());
+				const FPointDamageEvent DamageEvent(1.0f, Hit, Instigator->GetActorForwardVector(), UDamageType::StaticClass());
+				Pawn->TakeDamage(1.0f, DamageEvent, nullptr, Instigator->GetWeapon());
+			}
+			if (UHoloDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UHoloDamageQueueSubsystem>())
+			{
+				DamageQueue->Auth_FlushDamage();
+			}
+			const uint64 DamageEnd = FPlatformTime::Cycles64();
+
+			// Explosions at the same random spots every run: spatial hash update, broad phase, occlusion traces and the
+			// radial damage. Traces are blocking here, so the whole batch is measured in this section rather than next tick.
+			if (AreaDamage)
+			{
+				FRandomStream RandomStream(Frame);
+				for (int32 Index = 0; Index < NumExplosions; ++Index)
+				{
+					const FVector2D Offset = FVector2D(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f)) * SpawnRadius;
+					AreaDamage->Auth_QueueExplosion(FVector(Offset, 0.0f), ExplosionParams, nullptr, nullptr);
+				}
+				AreaDamage->Auth_ProcessExplosions(true);
+			}
+			const uint64 ExplosionsEnd = FPlatformTime::Cycles64();
+
+			for (AHoloPawn* Pawn : Pawns)
+			{
+				if (UHoloHealthComponent* HealthComponent = Pawn->GetHealthComponent())
+				{
+					HealthComponent->Auth_ResetHealth();
+				}
+			}
+
+			if (Frame >= 0)
+			{
+				WorldTickTimes.Add(FPlatformTime::ToMilliseconds64(WorldTickEnd - WorldTickStart));
+				if (NumShotsThisFrame > 0)
+				{
+					FireTimes.Add(FPlatformTime::ToMilliseconds64(FireEnd - WorldTickEnd));
+				}
+				DamageTimes.Add(FPlatformTime::ToMilliseconds64(DamageEnd - FireEnd));
+				ExplosionTimes.Add(FPlatformTime::ToMilliseconds64(ExplosionsEnd - DamageEnd));
+			}
+		}
+
+		for (const TPair<AHoloWeapon*, FDelegateHandle>& ShotFiredHandle : ShotFiredHandles)
+		{
+			ShotFiredHandle.Key->OnShotFiredDelegate.Remove(ShotFiredHandle.Value);
+		}
+
+		TMap<FString, double> Results;
+		Results.Add(WorldTickSection, GetMedian(WorldTickTimes));
+		Results.Add(FireSection, GetMedian(FireTimes));
+		Results.Add(DamageSection, GetMedian(DamageTimes));
+		Results.Add(ExplosionsSection, GetMedian(ExplosionTimes));
+		return Results;
+	}
+
+	static bool LoadBaseline(const FString& Path, TMap<FString, double>& OutBaseline)
+	{
+		FString Json;
+		if (!FFileHelper::LoadFileToString(Json, *Path))
+		{
+			return false;
+		}
+
+		TSharedPtr<FJsonObject> Root;
+		if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+		{
+			return false;
+		}
+
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Field : Root->Values)
+		{
+			OutBaseline.Add(Field.Key, Field.Value->AsNumber());
+		}
+		return true;
+	}
+
+	static bool SaveBaseline(const FString& Path, const TMap<FString, double>& Results)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		for (const TPair<FString, double>& Result : Results)
+		{
+			Root->SetNumberField(Result.Key, Result.Value);
+		}
+
+		FString Json;
+		FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Json));
+		return FFileHelper::SaveStringToFile(Json, *Path);
+	}
+}
+
+/**
+ * Benchmarks the gameplay hot paths in an empty game world: spawns armed pawns in a ring facing each other,
+ * then measures, over a fixed number of frames, the world tick (pawn, weapon and subsystem ticks), firing (fire traces
+ * and lag compensation), damage processing and a batch of explosions (area damage broad phase and occlusion traces).
+ * Median costs are compared against the baseline JSON file committed in Build/Perf: the test fails if any of them regressed
+ * beyond the tolerance, or if there's no baseline to compare against.
+ *
+ * UE4Editor-Cmd Holo.uproject -nullrhi -unattended -ExecCmds="Automation RunTests Holo.Perf; Quit"
+ *   [-Pawns=64] [-Explosions=50] [-Frames=600] [-Tolerance=0.15] [-Baseline=<Path>] [-UpdateBaseline]
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHoloPerfBenchmarkTest, "Holo.Perf.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FHoloPerfBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	int32 NumPawns = 64;
+	int32 NumExplosions = 50;
+	int32 NumWarmupFrames = 60;
+	int32 NumFrames = 600;
+	float Tolerance = 0.15f;
+	FString PawnClassPath = TEXT("/Game/Holo/Characters/BP_CubeCharacter.BP_CubeCharacter_C");
+	FString BaselinePath = FPaths::ProjectDir() / TEXT("Build/Perf/HoloPerfBaseline.json");
+
+	FParse::Value(CommandLine, TEXT("Pawns="), NumPawns);
+	FParse::Value(CommandLine, TEXT("Explosions="), NumExplosions);
+	FParse::Value(CommandLine, TEXT("WarmupFrames="), NumWarmupFrames);
+	FParse::Value(CommandLine, TEXT("Frames="), NumFrames);
+	FParse::Value(CommandLine, TEXT("Tolerance="), Tolerance);
+	FParse::Value(CommandLine, TEXT("PawnClass="), PawnClassPath);
+	FParse::Value(CommandLine, TEXT("Baseline="), BaselinePath);
+	const bool bUpdateBaseline = FParse::Param(CommandLine, TEXT("UpdateBaseline"));
+
+	UClass* PawnClass = LoadClass<AHoloPawn>(nullptr, *PawnClassPath);
+	if (!PawnClass)
+	{
+		AddError(FString::Printf(TEXT("Unable to load pawn class %s"), *PawnClassPath));
+		return false;
+	}
+
+	// An empty standalone game world: everything runs with authority, like on a server
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("HoloPerfBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	TArray<AHoloPawn*> Pawns;
+	HoloPerfBenchmark::SpawnPawns(World, PawnClass, FMath::Max(NumPawns, 2), Pawns);
+
+	const TMap<FString, double> Results = HoloPerfBenchmark::RunBenchmark(World, Pawns, FMath::Max(NumExplosions, 0), NumWarmupFrames, FMath::Max(NumFrames, 1));
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	for (const TPair<FString, double>& Result : Results)
+	{
+		AddInfo(FString::Printf(TEXT("%s %.4f ms/frame"), *Result.Key, Result.Value));
+	}
+
+	if (bUpdateBaseline)
+	{
+		AddInfo(FString::Printf(TEXT("Writing baseline %s"), *BaselinePath));
+		TestTrue(TEXT("Baseline written"), HoloPerfBenchmark::SaveBaseline(BaselinePath, Results));
+		return true;
+	}
+
+	// A missing baseline would otherwise let every run pass
+	TMap<FString, double> Baseline;
+	if (!HoloPerfBenchmark::LoadBaseline(BaselinePath, Baseline))
+	{
+		AddError(FString::Printf(TEXT("Unable to load baseline %s, run with -UpdateBaseline to create it"), *BaselinePath));
+		return false;
+	}
+
+	for (const TPair<FString, double>& Result : Results)
+	{
+		const double* BaselineTime = Baseline.Find(Result.Key);
+		if (!BaselineTime)
+		{
+			AddError(FString::Printf(TEXT("%s is missing from the baseline, run with -UpdateBaseline to add it"), *Result.Key));
+			continue;
+		}
+
+		if (Result.Value > *BaselineTime * (1.0 + Tolerance))
+		{
+			AddError(FString::Printf(TEXT("%s regressed, %.4f ms/frame (baseline %.4f ms/frame, tolerance %.0f%%)"),
+				*Result.Key, Result.Value, *BaselineTime, Tolerance * 100.0f));
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
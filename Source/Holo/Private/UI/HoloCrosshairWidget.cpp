@@ -0,0 +1,190 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UI/HoloCrosshairWidget.h"
+
+#include "Holo.h"
+#include "Containers/Ticker.h"
+#include "Player/HoloPawn.h"
+#include "Weapons/HoloWeapon.h"
+
+namespace HoloCrosshair
+{
+	static constexpr float Thickness = 2.0f;
+	static constexpr float HitMarkerSize = 12.0f;
+
+	static void DrawSegment(FSlateWindowElementList& OutDrawElements, int32 LayerId, const FGeometry& AllottedGeometry, const FVector2D& Start, const FVector2D& End, const FLinearColor& Color)
+	{
+		TArray<FVector2D> Points;
+		Points.Add(Start);
+		Points.Add(End);
+		FSlateDrawElement::MakeLines(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), Points, ESlateDrawEffect::None, Color, true, Thickness);
+	}
+}
+
+void UHoloCrosshairWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	AHoloPawn* Pawn = CastChecked<AHoloPawn>(GetOwningPlayerPawn());
+	ColorChanged(Pawn->GetColor());
+	WeaponChanged(Pawn->GetWeapon());
+
+	Pawn->OnColorChangedDelegate.AddDynamic(this, &UHoloCrosshairWidget::ColorChanged);
+	Pawn->OnDyingDelegate.AddDynamic(this, &UHoloCrosshairWidget::PawnDying);
+	RespawnedHandle = Pawn->OnRespawnedDelegate.AddUObject(this, &UHoloCrosshairWidget::PawnRespawned);
+	WeaponChangedHandle = Pawn->OnWeaponChangedDelegate.AddUObject(this, &UHoloCrosshairWidget::WeaponChanged);
+}
+
+void UHoloCrosshairWidget::NativeDestruct()
+{
+	WeaponChanged(nullptr);
+
+	if (AHoloPawn* Pawn = Cast<AHoloPawn>(GetOwningPlayerPawn()))
+	{
+		Pawn->OnColorChangedDelegate.RemoveDynamic(this, &UHoloCrosshairWidget::ColorChanged);
+		Pawn->OnDyingDelegate.RemoveDynamic(this, &UHoloCrosshairWidget::PawnDying);
+		Pawn->OnRespawnedDelegate.Remove(RespawnedHandle);
+		Pawn->OnWeaponChangedDelegate.Remove(WeaponChangedHandle);
+	}
+
+	FTicker::GetCoreTicker().RemoveTicker(RepaintTickerHandle);
+	RepaintTickerHandle.Reset();
+
+	Super::NativeDestruct();
+}
+
+int32 UHoloCrosshairWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	int32 MaxLayerId = Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+
+	HOLO_INC_COUNTER(WidgetPaints, 1);
+
+	const AHoloPawn* Pawn = Cast<AHoloPawn>(GetOwningPlayerPawn());
+	if (!Pawn || Pawn->bIsDying)
+	{
+		return MaxLayerId;
+	}
+
+	++MaxLayerId;
+	const FVector2D Center = AllottedGeometry.GetLocalSize() * 0.5f;
+
+	// Crosshair
+	const float ExpandWeight = GetCrosshairExpandWeight();
+	const float ArmOffset = FMath::Lerp(CrosshairSize.X, CrosshairSize.Y, ExpandWeight) * 0.5f;
+	const float GapSize = FMath::Lerp(CrosshairGapSize.X, CrosshairGapSize.Y, ExpandWeight);
+	const float GapOffset = GapSize * 0.5f;
+	const FLinearColor CrosshairColor = Color * 1.33f;
+
+	HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(-ArmOffset, 0.0f), Center + FVector2D(-GapOffset, 0.0f), CrosshairColor);
+	HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(GapOffset, 0.0f), Center + FVector2D(ArmOffset, 0.0f), CrosshairColor);
+	HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(0.0f, -ArmOffset), Center + FVector2D(0.0f, -GapOffset), CrosshairColor);
+	HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(0.0f, GapOffset), Center + FVector2D(0.0f, ArmOffset), CrosshairColor);
+
+	// Hit markers are shown as soon as a hit is predicted, and disappear if the server rolls it back
+	float HitMarkerAge = 0.0f;
+	bool bHitMarkerConfirmed = false;
+	if (Weapon.IsValid() && Weapon->GetHitMarker(HitMarkerAge, bHitMarkerConfirmed) && HitMarkerAge < HitMarkerDuration)
+	{
+		FLinearColor HitMarkerColor = bHitMarkerConfirmed ? ConfirmedHitMarkerColor : PredictedHitMarkerColor;
+		HitMarkerColor.A *= 1.0f - HitMarkerAge / HitMarkerDuration;
+
+		// Four diagonal strokes around the crosshair gap
+		const float Inner = GapOffset * INV_SQRT_2;
+		const float Outer = Inner + HoloCrosshair::HitMarkerSize * INV_SQRT_2;
+		HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(-Outer, -Outer), Center + FVector2D(-Inner, -Inner), HitMarkerColor);
+		HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(Inner, -Inner), Center + FVector2D(Outer, -Outer), HitMarkerColor);
+		HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(-Outer, Outer), Center + FVector2D(-Inner, Inner), HitMarkerColor);
+		HoloCrosshair::DrawSegment(OutDrawElements, MaxLayerId, AllottedGeometry, Center + FVector2D(Inner, Inner), Center + FVector2D(Outer, Outer), HitMarkerColor);
+	}
+
+	return MaxLayerId;
+}
+
+void UHoloCrosshairWidget::ColorChanged(const FLinearColor& NewColor)
+{
+	Color = NewColor;
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void UHoloCrosshairWidget::PawnDying()
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void UHoloCrosshairWidget::PawnRespawned()
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void UHoloCrosshairWidget::WeaponChanged(AHoloWeapon* NewWeapon)
+{
+	if (Weapon.IsValid())
+	{
+		Weapon->OnShotFiredDelegate.Remove(ShotFiredHandle);
+		Weapon->OnHitFeedbackDelegate.Remove(HitFeedbackHandle);
+	}
+
+	Weapon = NewWeapon;
+
+	if (NewWeapon)
+	{
+		ShotFiredHandle = NewWeapon->OnShotFiredDelegate.AddUObject(this, &UHoloCrosshairWidget::ShotFired);
+		HitFeedbackHandle = NewWeapon->OnHitFeedbackDelegate.AddUObject(this, &UHoloCrosshairWidget::HitFeedback);
+	}
+}
+
+void UHoloCrosshairWidget::ShotFired()
+{
+	LastShotTime = GetWorld()->GetTimeSeconds();
+	StartAnimating();
+}
+
+void UHoloCrosshairWidget::HitFeedback(uint16 ShotSequence, EHoloHitFeedback Feedback)
+{
+	// Rolled back hit markers must disappear right away as well
+	StartAnimating();
+}
+
+void UHoloCrosshairWidget::StartAnimating()
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	if (!RepaintTickerHandle.IsValid())
+	{
+		const float Interval = AnimationRepaintRate > 0.0f ? 1.0f / AnimationRepaintRate : 0.0f;
+		RepaintTickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UHoloCrosshairWidget::AnimationTick), Interval);
+	}
+}
+
+bool UHoloCrosshairWidget::AnimationTick(float DeltaTime)
+{
+	// One last repaint once the animations are over, to draw the widget at rest
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	if (!IsAnimating())
+	{
+		RepaintTickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool UHoloCrosshairWidget::IsAnimating() const
+{
+	float HitMarkerAge = 0.0f;
+	bool bHitMarkerConfirmed = false;
+	const bool bHitMarkerVisible = Weapon.IsValid() && Weapon->GetHitMarker(HitMarkerAge, bHitMarkerConfirmed) && HitMarkerAge < HitMarkerDuration;
+	return bHitMarkerVisible || GetCrosshairExpandWeight() > 0.0f;
+}
+
+float UHoloCrosshairWidget::GetCrosshairExpandWeight() const
+{
+	const UWorld* World = GetWorld();
+	if (!World || CrosshairRecoveryTime <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	return FMath::Clamp(1.0f - (World->GetTimeSeconds() - LastShotTime) / CrosshairRecoveryTime, 0.0f, 1.0f);
+}
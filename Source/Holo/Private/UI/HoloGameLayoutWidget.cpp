@@ -2,3 +2,65 @@
 
 
 #include "UI/HoloGameLayoutWidget.h"
+
+#include "Holo.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/CanvasPanelSlot.h"
+#include "Components/InvalidationBox.h"
+#include "Components/PanelWidget.h"
+#include "UI/HoloCrosshairWidget.h"
+#include "UI/HoloKillFeedWidget.h"
+#include "UI/HoloPlayerHealthWidget.h"
+
+void UHoloGameLayoutWidget::NativeOnInitialized()
+{
+	Super::NativeOnInitialized();
+
+	if (!CrosshairWidget)
+	{
+		CrosshairWidget = Cast<UHoloCrosshairWidget>(AddDefaultWidget(UHoloCrosshairWidget::StaticClass(), FAnchors(0.0f, 0.0f, 1.0f, 1.0f), FMargin(0.0f)));
+	}
+
+	if (!KillFeedWidget)
+	{
+		// Offsets of point anchors are the position and size of the widget
+		KillFeedWidget = Cast<UHoloKillFeedWidget>(AddDefaultWidget(UHoloKillFeedWidget::StaticClass(), FAnchors(1.0f, 0.0f), FMargin(-420.0f, 20.0f, 400.0f, 120.0f)));
+	}
+
+	WrapInInvalidationBox(PlayerHealthWidget);
+	WrapInInvalidationBox(CrosshairWidget);
+	WrapInInvalidationBox(KillFeedWidget);
+}
+
+UUserWidget* UHoloGameLayoutWidget::AddDefaultWidget(TSubclassOf<UUserWidget> WidgetClass, const FAnchors& Anchors, const FMargin& Offsets)
+{
+	UPanelWidget* RootPanel = Cast<UPanelWidget>(GetRootWidget());
+	if (!RootPanel)
+	{
+		return nullptr;
+	}
+
+	UUserWidget* Widget = CreateWidget<UUserWidget>(this, WidgetClass);
+	UPanelSlot* Slot = RootPanel->AddChild(Widget);
+	if (UCanvasPanelSlot* CanvasSlot = Cast<UCanvasPanelSlot>(Slot))
+	{
+		CanvasSlot->SetAnchors(Anchors);
+		CanvasSlot->SetOffsets(Offsets);
+	}
+
+	return Widget;
+}
+
+void UHoloGameLayoutWidget::WrapInInvalidationBox(UWidget* Widget)
+{
+	UPanelWidget* Parent = Widget ? Widget->GetParent() : nullptr;
+	if (!Parent || Parent->IsA<UInvalidationBox>())
+	{
+		return;
+	}
+
+	// Same as wrapping the widget in the designer: the box takes over the widget's slot, and its layout
+	UInvalidationBox* InvalidationBox = WidgetTree->ConstructWidget<UInvalidationBox>();
+	Parent->ReplaceChildAt(Parent->GetChildIndex(Widget), InvalidationBox);
+	InvalidationBox->SetContent(Widget);
+}
@@ -0,0 +1,102 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UI/HoloKillFeedWidget.h"
+
+#include "Holo.h"
+#include "Core/HoloGameState.h"
+#include "GameFramework/PlayerState.h"
+#include "Styling/CoreStyle.h"
+#include "TimerManager.h"
+
+#define LOCTEXT_NAMESPACE "HoloKillFeed"
+
+UHoloKillFeedWidget::UHoloKillFeedWidget(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Font = FCoreStyle::GetDefaultFontStyle("Regular", 14);
+}
+
+void UHoloKillFeedWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	if (AHoloGameState* GameState = GetWorld()->GetGameState<AHoloGameState>())
+	{
+		KillHandle = GameState->OnKillDelegate.AddUObject(this, &UHoloKillFeedWidget::KillNotified);
+	}
+}
+
+void UHoloKillFeedWidget::NativeDestruct()
+{
+	if (AHoloGameState* GameState = GetWorld()->GetGameState<AHoloGameState>())
+	{
+		GameState->OnKillDelegate.Remove(KillHandle);
+	}
+
+	GetWorld()->GetTimerManager().ClearTimer(ExpireTimerHandle);
+
+	Super::NativeDestruct();
+}
+
+int32 UHoloKillFeedWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	int32 MaxLayerId = Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+
+	HOLO_INC_COUNTER(WidgetPaints, 1);
+
+	if (Entries.Num() == 0)
+	{
+		return MaxLayerId;
+	}
+
+	++MaxLayerId;
+	const FVector2D LineSize(AllottedGeometry.GetLocalSize().X, LineHeight);
+	for (int32 Index = Entries.Num() - 1, Line = 0; Index >= 0; --Index, ++Line)
+	{
+		const FPaintGeometry LineGeometry = AllottedGeometry.ToPaintGeometry(FVector2D(0.0f, Line * LineHeight), LineSize);
+		FSlateDrawElement::MakeText(OutDrawElements, MaxLayerId, LineGeometry, Entries[Index].Text, Font, ESlateDrawEffect::None, TextColor);
+	}
+
+	return MaxLayerId;
+}
+
+void UHoloKillFeedWidget::KillNotified(APlayerState* Killer, APlayerState* Victim)
+{
+	const FText VictimName = Victim ? FText::FromString(Victim->GetPlayerName()) : LOCTEXT("Unknown", "Someone");
+	const FText Text = Killer && Killer != Victim
+		? FText::Format(LOCTEXT("Kill", "{0} killed {1}"), FText::FromString(Killer->GetPlayerName()), VictimName)
+		: FText::Format(LOCTEXT("Death", "{0} died"), VictimName);
+
+	if (Entries.Num() > 0 && Entries.Num() >= MaxEntries)
+	{
+		Entries.RemoveAt(0, Entries.Num() - FMath::Max(MaxEntries - 1, 0), false);
+	}
+	Entries.Add({ Text, GetWorld()->GetTimeSeconds() + EntryDuration });
+
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	if (!GetWorld()->GetTimerManager().IsTimerActive(ExpireTimerHandle))
+	{
+		ExpireEntries();
+	}
+}
+
+void UHoloKillFeedWidget::ExpireEntries()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const int32 NumExpired = Entries.IndexByPredicate([CurrentTime](const FKillFeedEntry& Entry) { return Entry.ExpireTime > CurrentTime; });
+	if (NumExpired != 0)
+	{
+		Entries.RemoveAt(0, NumExpired == INDEX_NONE ? Entries.Num() : NumExpired, false);
+		Invalidate(EInvalidateWidgetReason::Paint);
+	}
+
+	// Entries are sorted by expiration time: only the oldest one needs a timer
+	if (Entries.Num() > 0)
+	{
+		GetWorld()->GetTimerManager().SetTimer(ExpireTimerHandle, this, &UHoloKillFeedWidget::ExpireEntries, Entries[0].ExpireTime - CurrentTime, false);
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -3,11 +3,15 @@
 
 #include "UI/HoloPlayerHealthWidget.h"
 
+#include "Holo.h"
 #include "Components/ProgressBar.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Player/HoloHealthComponent.h"
 #include "Player/HoloPawn.h"
 
+DECLARE_CYCLE_STAT(TEXT("Health Widget Update"), STAT_HoloHealthWidgetUpdate, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Widget Updates"), STAT_HoloWidgetUpdates, STATGROUP_Holo);
+
 void UHoloPlayerHealthWidget::NativeConstruct()
 {
 	Super::NativeConstruct();
@@ -24,8 +28,18 @@ void UHoloPlayerHealthWidget::NativeConstruct()
 	HealthComponent->OnHealthChangedDelegate.AddDynamic(this, &UHoloPlayerHealthWidget::HealthChanged);
 }
 
+int32 UHoloPlayerHealthWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	HOLO_INC_COUNTER(WidgetPaints, 1);
+
+	return Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+}
+
 void UHoloPlayerHealthWidget::ColorChanged(const FLinearColor& NewColor)
 {
+	HOLO_SCOPED_TIMING(HealthWidgetUpdate);
+	HOLO_INC_COUNTER(WidgetUpdates, 1);
+
 	if (HealthProgressBar)
 	{
 		HealthProgressBar->SetFillColorAndOpacity(NewColor);
@@ -34,6 +48,9 @@ void UHoloPlayerHealthWidget::ColorChanged(const FLinearColor& NewColor)
 
 void UHoloPlayerHealthWidget::HealthChanged(float CurrentHealth, float MaxHealth)
 {
+	HOLO_SCOPED_TIMING(HealthWidgetUpdate);
+	HOLO_INC_COUNTER(WidgetUpdates, 1);
+
 	if (HealthProgressBar)
 	{
 		HealthProgressBar->SetPercent(UKismetMathLibrary::NormalizeToRange(CurrentHealth, 0.0f, MaxHealth));
@@ -0,0 +1,86 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapons/HoloAimTraceSubsystem.h"
+
+#include "Holo.h"
+#include "Weapons/HoloWeapon.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Aim Traces Issued"), STAT_HoloAimTracesIssued, STATGROUP_Holo);
+
+namespace HoloAimTrace
+{
+	/** The buffer index is stored in the top bit of the trace user data, the request index in the others. */
+	static constexpr uint32 BufferShift = 31;
+	static constexpr uint32 IndexMask = (1u << BufferShift) - 1;
+}
+
+void UHoloAimTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UHoloAimTraceSubsystem::OnAimTraceCompleted);
+}
+
+void UHoloAimTraceSubsystem::Tick(float DeltaTime)
+{
+	if (PendingRequests.Num() == 0)
+	{
+		return;
+	}
+
+	// The buffer we're about to reuse was issued two frames ago: its results have already been delivered
+	CurrentBuffer ^= 1;
+	TArray<FAimTraceRequest>& Requests = InFlightRequests[CurrentBuffer];
+	Swap(Requests, PendingRequests);
+	PendingRequests.Reset();
+
+	UWorld* World = GetWorld();
+	const FName ProfileName = UCollisionProfile::BlockAllDynamic_ProfileName;
+	for (int32 Index = 0; Index < Requests.Num(); ++Index)
+	{
+		const FAimTraceRequest& Request = Requests[Index];
+		const AHoloWeapon* Weapon = Request.Weapon.Get();
+		if (!Weapon)
+		{
+			continue;
+		}
+
+		const FCollisionQueryParams QueryParams(TEXT("PlayerAim"), false, Weapon->GetOwner());
+		const uint32 UserData = (CurrentBuffer << HoloAimTrace::BufferShift) | static_cast<uint32>(Index);
+		World->AsyncLineTraceByProfile(EAsyncTraceType::Single, Request.TraceStart, Request.TraceEnd, ProfileName, QueryParams, &TraceDelegate, UserData);
+	}
+
+	HOLO_INC_COUNTER(AimTracesIssued, Requests.Num());
+}
+
+TStatId UHoloAimTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloAimTraceSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloAimTraceSubsystem::RequestAimTrace(AHoloWeapon* Weapon, const FVector& TraceStart, const FVector& TraceEnd, const FTransform& ViewTransform)
+{
+	PendingRequests.Add({ Weapon, TraceStart, TraceEnd, ViewTransform });
+}
+
+void UHoloAimTraceSubsystem::OnAimTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const uint32 Buffer = Datum.UserData >> HoloAimTrace::BufferShift;
+	const int32 Index = static_cast<int32>(Datum.UserData & HoloAimTrace::IndexMask);
+	if (!InFlightRequests[Buffer].IsValidIndex(Index))
+	{
+		return;
+	}
+
+	const FAimTraceRequest& Request = InFlightRequests[Buffer][Index];
+	AHoloWeapon* Weapon = Request.Weapon.Get();
+	if (!Weapon)
+	{
+		return;
+	}
+
+	// If we hit something, that's what we're aiming at
+	const bool bHit = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+	Weapon->ApplyAimLocation(bHit ? FVector(Datum.OutHits[0].ImpactPoint) : Request.TraceEnd, Request.ViewTransform);
+}
@@ -0,0 +1,248 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapons/HoloAreaDamageSubsystem.h"
+
+#include "Holo.h"
+#include "Components/CapsuleComponent.h"
+#include "Player/HoloPawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Process Explosions"), STAT_HoloProcessExplosions, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosions"), STAT_HoloExplosions, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion Occlusion Traces"), STAT_HoloExplosionOcclusionTraces, STATGROUP_Holo);
+
+void UHoloAreaDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UHoloAreaDamageSubsystem::OnOcclusionTraceCompleted);
+}
+
+void UHoloAreaDamageSubsystem::Deinitialize()
+{
+	Pawns.Empty();
+	PawnCells.Empty();
+	Grid.Empty();
+	QueuedExplosions.Empty();
+	InFlightExplosions.Empty();
+	InFlightTargets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHoloAreaDamageSubsystem::Tick(float DeltaTime)
+{
+	if (QueuedExplosions.Num() > 0 || InFlightExplosions.Num() > 0)
+	{
+		Auth_ProcessExplosions();
+	}
+}
+
+TStatId UHoloAreaDamageSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloAreaDamageSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloAreaDamageSubsystem::RegisterPawn(AHoloPawn* Pawn)
+{
+	if (!Pawn || Pawns.Contains(Pawn))
+	{
+		return;
+	}
+
+	const int32 Index = Pawns.Add(Pawn);
+	PawnCells.Add(GetCell(Pawn->GetActorLocation()));
+	Grid.FindOrAdd(PawnCells[Index]).Add(Index);
+}
+
+void UHoloAreaDamageSubsystem::UnregisterPawn(AHoloPawn* Pawn)
+{
+	const int32 Index = Pawns.Find(Pawn);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	TArray<int32>& CellPawns = Grid.FindChecked(PawnCells[Index]);
+	CellPawns.RemoveSingleSwap(Index, false);
+	if (CellPawns.Num() == 0)
+	{
+		Grid.Remove(PawnCells[Index]);
+	}
+
+	// The last pawn takes the place of the removed one: its cell must refer to its new index
+	const int32 LastIndex = Pawns.Num() - 1;
+	if (Index != LastIndex)
+	{
+		TArray<int32>& LastCellPawns = Grid.FindChecked(PawnCells[LastIndex]);
+		LastCellPawns[LastCellPawns.Find(LastIndex)] = Index;
+	}
+
+	Pawns.RemoveAtSwap(Index, 1, false);
+	PawnCells.RemoveAtSwap(Index, 1, false);
+}
+
+void UHoloAreaDamageSubsystem::Auth_QueueExplosion(const FVector& Origin, const FRadialDamageParams& Params, AController* EventInstigator, AActor* DamageCauser)
+{
+	checkf(IsServerWorld(), TEXT("UHoloAreaDamageSubsystem::Auth_QueueExplosion called on client"));
+
+	QueuedExplosions.Add({ Origin, Params, EventInstigator, DamageCauser });
+}
+
+void UHoloAreaDamageSubsystem::Auth_ProcessExplosions(bool bBlockingTraces)
+{
+	checkf(IsServerWorld(), TEXT("UHoloAreaDamageSubsystem::Auth_ProcessExplosions called on client"));
+
+	HOLO_SCOPED_TIMING(ProcessExplosions);
+
+	// Async traces complete during the next frame: until then, new explosions wait for the batch in flight
+	if (NumCompletedTraces < InFlightTargets.Num())
+	{
+		return;
+	}
+
+	ApplyInFlightExplosions();
+
+	if (QueuedExplosions.Num() > 0)
+	{
+		UpdateGrid();
+		IssueOcclusionTraces(bBlockingTraces);
+	}
+
+	if (bBlockingTraces)
+	{
+		ApplyInFlightExplosions();
+	}
+}
+
+void UHoloAreaDamageSubsystem::UpdateGrid()
+{
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		const FIntVector Cell = GetCell(Pawns[Index]->GetActorLocation());
+		if (Cell == PawnCells[Index])
+		{
+			continue;
+		}
+
+		TArray<int32>& OldCellPawns = Grid.FindChecked(PawnCells[Index]);
+		OldCellPawns.RemoveSingleSwap(Index, false);
+		if (OldCellPawns.Num() == 0)
+		{
+			Grid.Remove(PawnCells[Index]);
+		}
+
+		Grid.FindOrAdd(Cell).Add(Index);
+		PawnCells[Index] = Cell;
+	}
+}
+
+void UHoloAreaDamageSubsystem::ApplyInFlightExplosions()
+{
+	// Exposed pawns take radial damage: AActor::TakeDamage applies the falloff to the closest point of the pawn
+	for (const FExplosionTarget& Target : InFlightTargets)
+	{
+		AHoloPawn* Pawn = Target.Pawn.Get();
+		if (Target.bOccluded || !Pawn || Pawn->bIsDying)
+		{
+			continue;
+		}
+
+		const FExplosion& Explosion = InFlightExplosions[Target.Explosion];
+		const FVector Direction = (Target.ClosestPoint - Explosion.Origin).GetSafeNormal();
+
+		FRadialDamageEvent DamageEvent;
+		DamageEvent.Params = Explosion.Params;
+		DamageEvent.Origin = Explosion.Origin;
+		DamageEvent.ComponentHits.Add(FHitResult(Pawn, Pawn->GetCapsuleComponent(), Target.ClosestPoint, -Direction));
+		Pawn->TakeDamage(Explosion.Params.BaseDamage, DamageEvent, Explosion.EventInstigator.Get(), Explosion.DamageCauser.Get());
+	}
+
+	InFlightExplosions.Reset();
+	InFlightTargets.Reset();
+	NumCompletedTraces = 0;
+}
+
+void UHoloAreaDamageSubsystem::IssueOcclusionTraces(bool bBlockingTraces)
+{
+	UWorld* World = GetWorld();
+	const FCollisionQueryParams QueryParams(TEXT("ExplosionOcclusion"), false);
+
+	// Only level geometry shields from explosions: the pawns themselves don't
+	const FCollisionObjectQueryParams ObjectQueryParams(ECC_WorldStatic);
+
+	for (const FExplosion& Explosion : QueuedExplosions)
+	{
+		const int32 ExplosionIndex = InFlightExplosions.Add(Explosion);
+		const float Radius = Explosion.Params.GetMaxRadius();
+		const FIntVector MinCell = GetCell(Explosion.Origin - FVector(Radius));
+		const FIntVector MaxCell = GetCell(Explosion.Origin + FVector(Radius));
+
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+			{
+				for (int32 CellZ = MinCell.Z; CellZ <= MaxCell.Z; ++CellZ)
+				{
+					const TArray<int32>* CellPawns = Grid.Find(FIntVector(CellX, CellY, CellZ));
+					if (!CellPawns)
+					{
+						continue;
+					}
+
+					for (const int32 PawnIndex : *CellPawns)
+					{
+						AHoloPawn* Pawn = Pawns[PawnIndex];
+						if (Pawn->bIsDying || Pawn->IsHidden())
+						{
+							continue;
+						}
+
+						const FVector PawnLocation = Pawn->GetActorLocation();
+						const FVector ToExplosion = Explosion.Origin - PawnLocation;
+						const float Distance = ToExplosion.Size();
+						const float CollisionRadius = Pawn->GetSimpleCollisionRadius();
+						if (Distance - CollisionRadius >= Radius)
+						{
+							continue;
+						}
+
+						const FVector ClosestPoint = PawnLocation + ToExplosion.GetSafeNormal() * FMath::Min(CollisionRadius, Distance);
+						const int32 TargetIndex = InFlightTargets.Add({ Pawn, ExplosionIndex, ClosestPoint, false });
+						if (bBlockingTraces)
+						{
+							InFlightTargets[TargetIndex].bOccluded = World->LineTraceTestByObjectType(Explosion.Origin, PawnLocation, ObjectQueryParams, QueryParams);
+							++NumCompletedTraces;
+						}
+						else
+						{
+							World->AsyncLineTraceByObjectType(EAsyncTraceType::Test, Explosion.Origin, PawnLocation, ObjectQueryParams, QueryParams, &TraceDelegate, TargetIndex);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	HOLO_INC_COUNTER(Explosions, QueuedExplosions.Num());
+	HOLO_INC_COUNTER(ExplosionOcclusionTraces, InFlightTargets.Num());
+
+	QueuedExplosions.Reset();
+}
+
+void UHoloAreaDamageSubsystem::OnOcclusionTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const int32 TargetIndex = static_cast<int32>(Datum.UserData);
+	if (!InFlightTargets.IsValidIndex(TargetIndex))
+	{
+		return;
+	}
+
+	InFlightTargets[TargetIndex].bOccluded = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+	++NumCompletedTraces;
+}
+
+FIntVector UHoloAreaDamageSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
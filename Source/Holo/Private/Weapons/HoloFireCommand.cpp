@@ -0,0 +1,162 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapons/HoloFireCommand.h"
+
+#include "Holo.h"
+#include "Net/HoloNetQuantize.h"
+#include "UObject/CoreNet.h"
+#include "Weapons/HoloWeapon.h"
+
+void FHoloFireCommand::SerializePayload(FArchive& Ar)
+{
+	HoloNet::SerializePackedTime(Ar, ClientFireTime);
+	HoloNet::SerializeQuantizedOffset(Ar, MuzzleOffset, MaxMuzzleOffset, MuzzleOffsetBits);
+	HoloNet::SerializeOctahedralNormal(Ar, Direction, DirectionBits);
+}
+
+bool FHoloFireCommandPacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumCommands = Commands.Num();
+	Ar.SerializeInt(NumCommands, MaxCommands + 1);
+
+	uint16 FirstSequence = NumCommands > 0 && Ar.IsSaving() ? Commands[0].Sequence : 0;
+	if (NumCommands > 0)
+	{
+		Ar << FirstSequence;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Commands.SetNum(NumCommands);
+	}
+
+	for (uint32 Index = 0; Index < NumCommands; ++Index)
+	{
+		FHoloFireCommand& Command = Commands[Index];
+		checkSlow(Ar.IsLoading() || Command.Sequence == static_cast<uint16>(FirstSequence + Index));
+
+		Command.Sequence = static_cast<uint16>(FirstSequence + Index);
+		Command.SerializePayload(Ar);
+	}
+
+	return !Ar.IsError();
+}
+
+/** Compares the size of the fire and hit payloads against plain quantized vectors and full floats, the way they used to be sent. */
+static void BenchmarkShotSerialization(const TArray<FString>& Args)
+{
+	const int32 NumShots = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+	const float StartTime = 1234.5f;
+	FRandomStream Random(NumShots);
+
+	int64 LegacyCommandBits = 0;
+	int64 PackedCommandBits = 0;
+	int64 LegacyHitBits = 0;
+	int64 PackedHitBits = 0;
+	float MaxTimeError = 0.0f;
+	float MaxMuzzleError = 0.0f;
+	float MaxDirectionError = 0.0f;
+	float MaxImpactNormalError = 0.0f;
+	bool bSuccess = true;
+
+	FHoloFireCommandPacket Packet;
+	for (int32 Shot = 0; Shot < NumShots; ++Shot)
+	{
+		const FVector PawnLocation = Random.GetUnitVector() * Random.FRandRange(0.0f, 20000.0f);
+
+		FHoloFireCommand Command;
+		Command.Sequence = static_cast<uint16>(Shot);
+		Command.ClientFireTime = StartTime + Shot * 0.1f + Random.FRand() * 0.05f;
+		Command.MuzzleOffset = Random.GetUnitVector() * Random.FRandRange(20.0f, 120.0f);
+		Command.Direction = Random.GetUnitVector();
+
+		// Fire command, legacy layout: full float time, absolute muzzle location, 16 bits per normal component
+		{
+			FNetBitWriter Writer(nullptr, 1024);
+			float Time = Command.ClientFireTime;
+			FVector_NetQuantize MuzzleLocation(PawnLocation + Command.MuzzleOffset);
+			FVector_NetQuantizeNormal Direction(Command.Direction);
+			Writer << Time;
+			MuzzleLocation.NetSerialize(Writer, nullptr, bSuccess);
+			Direction.NetSerialize(Writer, nullptr, bSuccess);
+			LegacyCommandBits += Writer.GetNumBits();
+		}
+
+		// Fire command, packed layout: measure the precision lost in a round trip
+		{
+			FNetBitWriter Writer(nullptr, 1024);
+			FHoloFireCommand Sent = Command;
+			Sent.SerializePayload(Writer);
+
+			FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+			FHoloFireCommand Received;
+			Received.SerializePayload(Reader);
+
+			const float ReceivedTime = HoloNet::UnwrapPackedTime(Received.ClientFireTime, Command.ClientFireTime + 0.2f);
+			MaxTimeError = FMath::Max(MaxTimeError, FMath::Abs(ReceivedTime - Command.ClientFireTime));
+			MaxMuzzleError = FMath::Max(MaxMuzzleError, FVector::Dist(Received.MuzzleOffset, Command.MuzzleOffset));
+			MaxDirectionError = FMath::Max(MaxDirectionError, FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Received.Direction | Command.Direction, -1.0f, 1.0f))));
+		}
+
+		Packet.Commands.Add(Command);
+		if (Packet.Commands.Num() == FHoloFireCommandPacket::MaxCommands || Shot == NumShots - 1)
+		{
+			FNetBitWriter Writer(nullptr, 8192);
+			Packet.NetSerialize(Writer, nullptr, bSuccess);
+			PackedCommandBits += Writer.GetNumBits();
+			Packet.Commands.Reset();
+		}
+
+		// Hit event: most shots hit something
+		FInstantHitInfo HitInfo;
+		HitInfo.ServerFireTime = Command.ClientFireTime;
+		if (Random.FRand() < 0.7f)
+		{
+			HitInfo.bCausedDamage = Random.FRand() < 0.3f;
+			HitInfo.ImpactPoint = PawnLocation + Command.Direction * Random.FRandRange(100.0f, 5000.0f);
+			HitInfo.ImpactNormal = Random.GetUnitVector();
+		}
+
+		// Hit event, legacy layout: every field, always
+		{
+			FNetBitWriter Writer(nullptr, 1024);
+			float Time = HitInfo.ServerFireTime;
+			uint8 bCausedDamage = HitInfo.bCausedDamage;
+			FVector_NetQuantize ImpactPoint(HitInfo.ImpactPoint);
+			FVector_NetQuantizeNormal ImpactNormal(HitInfo.ImpactNormal);
+			Writer << Time;
+			Writer.SerializeBits(&bCausedDamage, 1);
+			ImpactPoint.NetSerialize(Writer, nullptr, bSuccess);
+			ImpactNormal.NetSerialize(Writer, nullptr, bSuccess);
+			LegacyHitBits += Writer.GetNumBits();
+		}
+
+		// Hit event, packed layout
+		{
+			FNetBitWriter Writer(nullptr, 1024);
+			HitInfo.NetSerialize(Writer, nullptr, bSuccess);
+			PackedHitBits += Writer.GetNumBits();
+
+			FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+			FInstantHitInfo Received;
+			Received.NetSerialize(Reader, nullptr, bSuccess);
+			if (!HitInfo.ImpactNormal.IsZero())
+			{
+				MaxImpactNormalError = FMath::Max(MaxImpactNormalError, FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Received.ImpactNormal | HitInfo.ImpactNormal, -1.0f, 1.0f))));
+			}
+		}
+	}
+
+	UE_LOG(LogHolo, Display, TEXT("Shot serialization over %d shots:"), NumShots);
+	UE_LOG(LogHolo, Display, TEXT("  Fire command: %.1f bits per shot (legacy: %.1f)"), static_cast<double>(PackedCommandBits) / NumShots, static_cast<double>(LegacyCommandBits) / NumShots);
+	UE_LOG(LogHolo, Display, TEXT("  Hit event: %.1f bits per shot (legacy: %.1f)"), static_cast<double>(PackedHitBits) / NumShots, static_cast<double>(LegacyHitBits) / NumShots);
+	UE_LOG(LogHolo, Display, TEXT("  Max errors: time %.4fs, muzzle %.3f, direction %.4f deg, impact normal %.3f deg"), MaxTimeError, MaxMuzzleError, MaxDirectionError, MaxImpactNormalError);
+}
+
+static FAutoConsoleCommand BenchmarkShotSerializationCommand(
+	TEXT("Holo.Net.BenchmarkShotSerialization"),
+	TEXT("Logs the number of bits per shot of the fire and hit payloads, compared to their legacy layout. Usage: Holo.Net.BenchmarkShotSerialization [NumShots]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkShotSerialization));
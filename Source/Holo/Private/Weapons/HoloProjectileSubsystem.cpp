@@ -0,0 +1,221 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapons/HoloProjectileSubsystem.h"
+
+#include "Holo.h"
+#include "Core/HoloEffectPoolSubsystem.h"
+#include "Net/HoloNetQuantize.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Weapons/HoloWeapon.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectiles Update"), STAT_HoloProjectilesUpdate, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Sweeps Issued"), STAT_HoloProjectileSweepsIssued, STATGROUP_Holo);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Projectiles"), STAT_HoloLiveProjectiles, STATGROUP_Holo);
+
+bool FHoloProjectileSpawn::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Origin.NetSerialize(Ar, Map, bOutSuccess);
+	HoloNet::SerializeOctahedralNormal(Ar, Direction, DirectionBits);
+	Ar << Seed;
+	HoloNet::SerializePackedTime(Ar, ServerSpawnTime);
+
+	bOutSuccess &= !Ar.IsError();
+	return true;
+}
+
+void UHoloProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SweepDelegate.BindUObject(this, &UHoloProjectileSubsystem::OnSweepCompleted);
+}
+
+void UHoloProjectileSubsystem::Tick(float DeltaTime)
+{
+	if (Weapons.Num() == 0)
+	{
+		return;
+	}
+
+	HOLO_SCOPED_TIMING(ProjectilesUpdate);
+
+	// Last frame's sweeps have completed: projectiles that hit something stop there, the others move to the end of their segment
+	if (bSweepsInFlight)
+	{
+		bSweepsInFlight = false;
+		for (int32 Index = Weapons.Num() - 1; Index >= 0; --Index)
+		{
+			if (!HasHit[Index])
+			{
+				continue;
+			}
+
+			if (UParticleSystemComponent* Trail = Trails[Index])
+			{
+				Trail->SetWorldLocation(Hits[Index].Location);
+			}
+			if (AHoloWeapon* Weapon = Weapons[Index])
+			{
+				Weapon->OnProjectileImpact(Hits[Index], Velocities[Index].GetSafeNormal(), Authoritative[Index]);
+			}
+			RemoveProjectile(Index);
+		}
+	}
+
+	// Expire projectiles, and those whose weapon is gone
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	for (int32 Index = Weapons.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Weapons[Index] || CurrentTime - SpawnTimes[Index] > Lifetimes[Index])
+		{
+			RemoveProjectile(Index);
+		}
+	}
+
+	const int32 NumProjectiles = Weapons.Num();
+	SET_DWORD_STAT(STAT_HoloLiveProjectiles, NumProjectiles);
+	if (NumProjectiles == 0)
+	{
+		return;
+	}
+
+	// Advance all projectiles at once along their trajectory: Origin + Velocity * t + Acceleration * t^2 / 2
+	const VectorRegister Half = VectorSetFloat1(0.5f);
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		SegmentStarts[Index] = SegmentEnds[Index];
+
+		const float Time = CurrentTime - SpawnTimes[Index];
+		const VectorRegister T = VectorSetFloat1(Time);
+		const VectorRegister HalfTSquared = VectorMultiply(Half, VectorMultiply(T, T));
+		const VectorRegister Origin = VectorLoadFloat3(&Origins[Index]);
+		const VectorRegister Velocity = VectorLoadFloat3(&Velocities[Index]);
+		const VectorRegister Acceleration = VectorLoadFloat3(&Accelerations[Index]);
+		const VectorRegister Position = VectorMultiplyAdd(Acceleration, HalfTSquared, VectorMultiplyAdd(Velocity, T, Origin));
+		VectorStoreFloat3(Position, &SegmentEnds[Index]);
+	}
+
+#if WITH_HOLO_COSMETICS
+	UpdateTrails(CurrentTime);
+#endif
+
+	// Check the swept segments for hits, results come back next frame
+	UWorld* World = GetWorld();
+	const FName ProfileName = UCollisionProfile::BlockAllDynamic_ProfileName;
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		HasHit[Index] = false;
+
+		const FCollisionQueryParams QueryParams(TEXT("Projectile"), false, Weapons[Index]->GetOwner());
+		World->AsyncSweepByProfile(EAsyncTraceType::Single, SegmentStarts[Index], SegmentEnds[Index], FQuat::Identity, ProfileName,
+			FCollisionShape::MakeSphere(Radii[Index]), QueryParams, &SweepDelegate, static_cast<uint32>(Index));
+	}
+
+	bSweepsInFlight = true;
+	HOLO_INC_COUNTER(ProjectileSweepsIssued, NumProjectiles);
+}
+
+TStatId UHoloProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloProjectileSubsystem::SpawnProjectile(AHoloWeapon* Weapon, const FHoloProjectileSpawn& Spawn, float LocalSpawnTime, bool bAuthoritative)
+{
+	if (!Weapon || Weapons.Num() >= MaxProjectiles)
+	{
+		return;
+	}
+
+	// Every machine derives the same spread from the seed
+	const FRandomStream Random(Spawn.Seed);
+	const FVector Direction = Random.VRandCone(Spawn.Direction, FMath::DegreesToRadians(Weapon->GetProjectileSpread()));
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const float SpawnTime = FMath::Max(LocalSpawnTime, CurrentTime - MaxFastForwardTime);
+
+	// Projectiles spawned with pending sweeps are only swept from next frame: they don't have a result to wait for
+	Weapons.Add(Weapon);
+	Origins.Add(Spawn.Origin);
+	Velocities.Add(Direction * Weapon->GetProjectileSpeed());
+	Accelerations.Add(FVector(0.0f, 0.0f, GetWorld()->GetGravityZ() * Weapon->GetProjectileGravityScale()));
+	SpawnTimes.Add(SpawnTime);
+	Lifetimes.Add(Weapon->GetProjectileLifetime());
+	Radii.Add(Weapon->GetProjectileRadius());
+	Authoritative.Add(bAuthoritative);
+	SegmentStarts.Add(Spawn.Origin);
+	SegmentEnds.Add(Spawn.Origin);
+	HasHit.Add(false);
+	Hits.AddDefaulted();
+
+	UParticleSystemComponent* Trail = nullptr;
+#if WITH_HOLO_COSMETICS
+	UHoloEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UHoloEffectPoolSubsystem>();
+	if (EffectPool && Holo::ShouldPlayCosmetics(Weapon))
+	{
+		Trail = EffectPool->SpawnEmitterAtLocation(Weapon->GetProjectileTrailEffect(), Spawn.Origin, Direction.Rotation());
+
+		// The pool restarts its oldest component once they're all in use: it no longer belongs to the projectile it was following
+		const int32 PreviousIndex = Trail ? Trails.Find(Trail) : INDEX_NONE;
+		if (PreviousIndex != INDEX_NONE)
+		{
+			Trails[PreviousIndex] = nullptr;
+		}
+	}
+#endif
+	Trails.Add(Trail);
+}
+
+void UHoloProjectileSubsystem::OnSweepCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const int32 Index = static_cast<int32>(Datum.UserData);
+	if (!bSweepsInFlight || !HasHit.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	if (Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit)
+	{
+		HasHit[Index] = true;
+		Hits[Index] = Datum.OutHits[0];
+	}
+}
+
+void UHoloProjectileSubsystem::UpdateTrails(float CurrentTime)
+{
+	for (int32 Index = 0; Index < Trails.Num(); ++Index)
+	{
+		UParticleSystemComponent* Trail = Trails[Index];
+		if (!Trail)
+		{
+			continue;
+		}
+
+		const FVector Velocity = Velocities[Index] + Accelerations[Index] * (CurrentTime - SpawnTimes[Index]);
+		Trail->SetWorldLocationAndRotation(SegmentEnds[Index], Velocity.Rotation());
+	}
+}
+
+void UHoloProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	// Let the trail fade out where the projectile stopped
+	if (UParticleSystemComponent* Trail = Trails[Index])
+	{
+		Trail->Deactivate();
+	}
+
+	Weapons.RemoveAtSwap(Index, 1, false);
+	Origins.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Accelerations.RemoveAtSwap(Index, 1, false);
+	SpawnTimes.RemoveAtSwap(Index, 1, false);
+	Lifetimes.RemoveAtSwap(Index, 1, false);
+	Radii.RemoveAtSwap(Index, 1, false);
+	Authoritative.RemoveAtSwap(Index, 1, false);
+	SegmentStarts.RemoveAtSwap(Index, 1, false);
+	SegmentEnds.RemoveAtSwap(Index, 1, false);
+	HasHit.RemoveAtSwap(Index, 1, false);
+	Hits.RemoveAtSwap(Index, 1, false);
+	Trails.RemoveAtSwap(Index, 1, false);
+}
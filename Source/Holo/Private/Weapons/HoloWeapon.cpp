@@ -2,23 +2,133 @@
 
 
 #include "Weapons/HoloWeapon.h"
-#include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "Holo.h"
+#include "Core/HoloAssetPreloadSubsystem.h"
+#include "Core/HoloEffectPoolSubsystem.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/HoloFireValidationSubsystem.h"
+#include "Net/HoloLagCompensationSubsystem.h"
+#include "Net/HoloNetQuantize.h"
 #include "Net/UnrealNetwork.h"
+#include "Player/HoloPawn.h"
 #include "Player/HoloPlayerController.h"
+#include "Weapons/HoloAimTraceSubsystem.h"
+#include "Weapons/HoloAreaDamageSubsystem.h"
+#include "Weapons/HoloWeaponRotationSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Aim Location"), STAT_HoloUpdateAimLocation, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Process Fire Command"), STAT_HoloProcessFireCommand, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Run Fire Trace"), STAT_HoloRunFireTrace, STATGROUP_Holo);
+DECLARE_CYCLE_STAT(TEXT("Run Lag Compensated Fire Trace"), STAT_HoloAuthRunFireTrace, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Commands Processed"), STAT_HoloFireCommandsProcessed, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Commands Rejected"), STAT_HoloFireCommandsRejected, STATGROUP_Holo);
+
+namespace HoloWeapon
+{
+	/** Slack allowed when comparing client fire times against the cooldown, to absorb jitter of the client's estimate of the server clock. */
+	static constexpr float FireTimeTolerance = 0.05f;
+
+	/** Explosions happen this far off the surface that was hit, so that their occlusion traces don't start inside it. */
+	static constexpr float ExplosionSurfaceOffset = 10.0f;
+}
 
+void FInstantHitInfo::PostReplicatedAdd(const FHoloHitEventLog& InArraySerializer)
+{
+	if (InArraySerializer.OwnerWeapon)
+	{
+		InArraySerializer.OwnerWeapon->OnHitEventReceived(*this);
+	}
+}
+
+bool FInstantHitInfo::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint8 bHit = Ar.IsSaving() && !ImpactNormal.IsZero() ? 1 : 0;
+	uint8 bDamage = Ar.IsSaving() && bCausedDamage ? 1 : 0;
+	Ar.SerializeBits(&bHit, 1);
+	Ar.SerializeBits(&bDamage, 1);
+
+	HoloNet::SerializePackedTime(Ar, ServerFireTime);
+
+	if (bHit)
+	{
+		ImpactPoint.NetSerialize(Ar, Map, bOutSuccess);
+		HoloNet::SerializeOctahedralNormal(Ar, ImpactNormal, ImpactNormalBits);
+	}
+	else if (Ar.IsLoading())
+	{
+		ImpactPoint = FVector::ZeroVector;
+		ImpactNormal = FVector::ZeroVector;
+	}
+
+	if (Ar.IsLoading())
+	{
+		bCausedDamage = bDamage != 0;
+	}
+
+	return !Ar.IsError();
+}
+
+void FHoloHitEventLog::AddEvent(const FInstantHitInfo& HitInfo, int32 MaxEvents)
+{
+	MarkItemDirty(Items.Add_GetRef(HitInfo));
+
+	const int32 NumToRemove = Items.Num() - FMath::Max(MaxEvents, 1);
+	if (NumToRemove > 0)
+	{
+		Items.RemoveAt(0, NumToRemove);
+		MarkArrayDirty();
+	}
+}
 
 AHoloWeapon::AHoloWeapon()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Weapons are rotated all at once by UHoloWeaponRotationSubsystem, they don't need to tick
+	PrimaryActorTick.bCanEverTick = false;
 	bReplicates = true;
 	bNetUseOwnerRelevancy = true;
+	NetDormancy = DORM_DormantAll;
 
 	// Define default cooldown/firing properties
 	FireCooldown = 0.4f;
+	FireMode = EHoloFireMode::SemiAuto;
+	BurstCount = 3;
 	BaseDamage = 30.0f;
-	LastFireTime = TNumericLimits<float>::Lowest();
+	MaxMuzzleLocationError = 200.0f;
+	bFiresProjectiles = false;
+	ProjectileSpeed = 5000.0f;
+	ProjectileGravityScale = 0.0f;
+	ProjectileLifetime = 3.0f;
+	ProjectileRadius = 5.0f;
+	ProjectileSpread = 0.0f;
+	bExplodesOnImpact = false;
+	ExplosionDamage = FRadialDamageParams(100.0f, 100.0f, 500.0f, 1.0f);
+	bTriggerHeld = false;
+	QueuedShots = 0;
+	NextShotTime = TNumericLimits<float>::Lowest();
 	AimTraceDistance = 5000.0f;
+	RotationSlot = INDEX_NONE;
+
+	// Define default fire commands stream properties
+	FireCommandResendInterval = 0.05f;
+	MaxFireCommandAge = 1.0f;
+	NextFireSequence = 0;
+	bHasNewFireCommands = false;
+	LastFireCommandsSendTime = TNumericLimits<float>::Lowest();
+	LastProcessedFireSequence = 0;
+	bHasProcessedFireCommand = false;
+	NextClientFireTime = TNumericLimits<float>::Lowest();
+	ConfirmedDamageMask = 0;
+	HitMarkerSequence = 0;
+	HitMarkerTime = TNumericLimits<float>::Lowest();
+	HitMarkerFeedback = EHoloHitFeedback::RolledBack;
+
+	// Define default fire events replication properties
+	MaxHitEvents = 8;
+	MaxHitEventAge = 1.0f;
+	HitEvents.OwnerWeapon = this;
 
 	// Define default values for aiming properties
 	AimInterpSpeed = 8.0f;
@@ -44,198 +154,616 @@ AHoloWeapon::AHoloWeapon()
 void AHoloWeapon::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (UHoloWeaponRotationSubsystem* RotationSubsystem = GetWorld()->GetSubsystem<UHoloWeaponRotationSubsystem>())
+	{
+		RotationSubsystem->RegisterWeapon(this);
+	}
+
+	// The default weapon's effects are preloaded with the map already, this covers any other weapon
+	UHoloAssetPreloadSubsystem* Preload = GetWorld()->GetSubsystem<UHoloAssetPreloadSubsystem>();
+	if (Preload && Holo::ShouldPlayCosmetics(this))
+	{
+		TArray<FSoftObjectPath> Assets;
+		GetPreloadAssets(Assets);
+		Preload->RequestPreload(Assets);
+	}
 }
 
-// Called every frame
-void AHoloWeapon::Tick(float DeltaTime)
+void AHoloWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UHoloWeaponRotationSubsystem* RotationSubsystem = GetWorld()->GetSubsystem<UHoloWeaponRotationSubsystem>())
+	{
+		RotationSubsystem->UnregisterWeapon(this);
+	}
 
-	AdjustWeaponRotation();
+	Super::EndPlay(EndPlayReason);
 }
 
-void AHoloWeapon::UpdateAimLocation(FVector& ViewLocation, FTransform& ViewTransform)
+void AHoloWeapon::UpdateAimLocation(const FVector& ViewLocation, const FTransform& ViewTransform)
 {
+	HOLO_SCOPED_TIMING(UpdateAimLocation);
+
 	const FVector ViewForward = ViewTransform.GetUnitAxis(EAxis::X);
 
 	// Prepare a line trace to find the first blocking primitive beneath the center of our view
 	const FVector& TraceStart = ViewLocation;
 	const FVector TraceEnd = TraceStart + (ViewForward * AimTraceDistance);
-	const FName ProfileName = UCollisionProfile::BlockAllDynamic_ProfileName;
-	const FCollisionQueryParams QueryParams(TEXT("PlayerAim"), false, GetOwner());
 
-	// If we hit something, that's what we're aiming at;
-	FHitResult Hit;
-	if (GetWorld()->LineTraceSingleByProfile(Hit, TraceStart, TraceEnd, ProfileName, QueryParams))
+	// Only the local player cares about what exactly it's aiming at: everyone else (including the server, since it's
+	// given the fire direction by clients) just points the weapon along the replicated view rotation.
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	UHoloAimTraceSubsystem* AimTraceSubsystem = GetWorld()->GetSubsystem<UHoloAimTraceSubsystem>();
+	if (OwnerPawn && OwnerPawn->IsLocallyControlled() && AimTraceSubsystem)
 	{
-		AimLocation = Hit.ImpactPoint;
-		// UKismetSystemLibrary::DrawDebugBox(this, AimLocation, FVector(20), FLinearColor::Green);
+		AimTraceSubsystem->RequestAimTrace(this, TraceStart, TraceEnd, ViewTransform);
 	}
 	else
 	{
-		AimLocation = TraceEnd;
+		ApplyAimLocation(TraceEnd, ViewTransform);
 	}
-	
-	// UKismetSystemLibrary::DrawDebugLine(this, TraceStart, TraceEnd, FLinearColor::Green);
+}
+
+void AHoloWeapon::ApplyAimLocation(const FVector& InAimLocation, const FTransform& ViewTransform)
+{
+	AimLocation = InAimLocation;
 
 	const FVector ViewAimLocation = ViewTransform.InverseTransformPosition(AimLocation);
 
 	// If the target to close aim is not valid
 	bAimLocationIsValid = ViewAimLocation.X > MuzzleHandle->GetRelativeLocation().X;
+
+	if (UHoloWeaponRotationSubsystem* RotationSubsystem = GetWorld()->GetSubsystem<UHoloWeaponRotationSubsystem>())
+	{
+		RotationSubsystem->SetAimTarget(this, AimLocation, bAimLocationIsValid);
+	}
 }
 
-void AHoloWeapon::AdjustWeaponRotation()
+void AHoloWeapon::SetRotationUpdatesEnabled(bool bEnabled)
 {
-	if (bAimLocationIsValid)
+	if (UHoloWeaponRotationSubsystem* RotationSubsystem = GetWorld()->GetSubsystem<UHoloWeaponRotationSubsystem>())
 	{
-		// Aiming at the target
-		const FRotator TargetRotation = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), AimLocation);
-		const FRotator NewRotation = FMath::RInterpTo(GetActorRotation(), TargetRotation, GetWorld()->GetDeltaSeconds(), AimInterpSpeed);
-		SetActorRotation(NewRotation);
+		RotationSubsystem->SetRotationEnabled(this, bEnabled);
 	}
-	else
+}
+
+void AHoloWeapon::StartFire()
+{
+	// The first shot of a trigger pull fires as soon as the cooldown of the previous one allows it, shots aren't banked while idle
+	const bool bWasFiring = bTriggerHeld || QueuedShots > 0;
+	if (!bWasFiring)
+	{
+		NextShotTime = FMath::Max(NextShotTime, GetWorld()->GetTimeSeconds());
+	}
+
+	switch (FireMode)
 	{
-		// Rotate the weapon to the side
-		const AActor* AttachParent = GetAttachParentActor();
-		const FQuat TargetRotation = AttachParent ? AttachParent->GetActorTransform().TransformRotation(FQuat(DropRotation)) : FQuat(DropRotation);
-		const FQuat NewRotation = FMath::QInterpTo(GetActorQuat(), TargetRotation, GetWorld()->GetDeltaSeconds(), DropInterpSpeed);
-		SetActorRotation(NewRotation);
+	case EHoloFireMode::SemiAuto:
+		QueuedShots = FMath::Max(QueuedShots, 1);
+		break;
+	case EHoloFireMode::FullAuto:
+		// Queue the first shot too, so that a tap released before it's due still fires
+		bTriggerHeld = true;
+		QueuedShots = FMath::Max(QueuedShots, 1);
+		break;
+	case EHoloFireMode::Burst:
+		QueuedShots = bWasFiring ? QueuedShots : FMath::Max(BurstCount, 1);
+		break;
 	}
 }
 
-void AHoloWeapon::HandleFireInput()
+void AHoloWeapon::StopFire()
 {
-	if (!CanFire())
+	bTriggerHeld = false;
+}
+
+void AHoloWeapon::ResetFireCommandStream()
+{
+	// Client side
+	bTriggerHeld = false;
+	QueuedShots = 0;
+	NextShotTime = TNumericLimits<float>::Lowest();
+	PendingFireCommands.Reset();
+	NextFireSequence = 0;
+	bHasNewFireCommands = false;
+	LastFireCommandsSendTime = TNumericLimits<float>::Lowest();
+	PredictedShots.Reset();
+	HitMarkerSequence = 0;
+	HitMarkerTime = TNumericLimits<float>::Lowest();
+	HitMarkerFeedback = EHoloHitFeedback::RolledBack;
+
+	// Server side: the sequences of the previous controller mustn't shadow the new one's
+	LastProcessedFireSequence = 0;
+	bHasProcessedFireCommand = false;
+	NextClientFireTime = TNumericLimits<float>::Lowest();
+	ConfirmedDamageMask = 0;
+}
+
+void AHoloWeapon::UpdateFiring()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const float ShotInterval = FMath::Max(FireCooldown, KINDA_SMALL_NUMBER);
+
+	// After a hitch, don't fire more than a packet can carry: the rest of the backlog is dropped
+	int32 NumShots = 0;
+	while ((bTriggerHeld || QueuedShots > 0) && NextShotTime <= CurrentTime)
 	{
-		return;
+		if (NumShots >= FHoloFireCommandPacket::MaxCommands)
+		{
+			NextShotTime = CurrentTime;
+			break;
+		}
+
+		// Shots that can't be fired (e.g. while aiming too close) are skipped, but keep their slot in the schedule
+		if (CanFire())
+		{
+			FireShot(NextShotTime);
+		}
+
+		NextShotTime += ShotInterval;
+		QueuedShots = FMath::Max(QueuedShots - 1, 0);
+		++NumShots;
 	}
+}
 
+void AHoloWeapon::FireShot(float ShotTime)
+{
 	const FVector MuzzleLocation = MuzzleHandle->GetComponentLocation();
 	const FVector Direction = MuzzleHandle->GetComponentQuat().Vector();
-	Server_TryFire(MuzzleLocation, Direction);
-	LastFireTime = GetWorld()->GetTimeSeconds();
 
-	if (!HasAuthority())
-	{
-		PlayFireEffects();
+	// Stamp the shot with the server time at which it was due, which may be a bit earlier in the frame
+	FHoloFireCommand Command;
+	Command.Sequence = NextFireSequence++;
+	Command.ClientFireTime = GetServerWorldTime() - (GetWorld()->GetTimeSeconds() - ShotTime);
+	Command.MuzzleOffset = MuzzleLocation - GetOwner()->GetActorLocation();
+	Command.Direction = Direction;
 
-		// Run a cosmetic line trace just to see whether we should spawn an impact effect
-		FHitResult Hit;
-		if (RunFireTrace(Hit))
+	if (HasAuthority())
+	{
+		// Locally controlled on the server, there's nothing to send nor predict
+		OnShotFiredDelegate.Broadcast();
+		if (Auth_ProcessFireCommand(Command))
 		{
-			const bool bWillProbablyCauseDamage = Hit.Actor.IsValid() && Hit.Actor->CanBeDamaged();
-			PlayImpactEffects(Hit.ImpactPoint, Hit.ImpactNormal, bWillProbablyCauseDamage);
+			NotifyHitFeedback(Command.Sequence, EHoloHitFeedback::Confirmed);
 		}
+		return;
+	}
+
+	// Queue the shot, it will be sent with the unacknowledged ones when the frame's input has been processed
+	if (PendingFireCommands.Num() >= FHoloFireCommandPacket::MaxCommands)
+	{
+		PendingFireCommands.RemoveAt(0, 1, false);
+	}
+	PendingFireCommands.Add(Command);
+	bHasNewFireCommands = true;
+
+	PlayFireEffects();
+	OnShotFiredDelegate.Broadcast();
+
+	// Predict the outcome of the shot with a local line trace, the server will tell us whether it agrees.
+	// The prediction key of the shot is its sequence number. Projectiles are predicted by simulating them locally,
+	// they only show their impact: hit markers stay for the instant hits the server can acknowledge right away.
+	FHitResult Hit;
+	bool bWillProbablyCauseDamage = false;
+	if (bFiresProjectiles)
+	{
+		FHoloProjectileSpawn Spawn;
+		Spawn.Origin = MuzzleLocation;
+		Spawn.Direction = Direction;
+		Spawn.Seed = Command.Sequence;
+		LaunchProjectile(Spawn, ShotTime, false);
+	}
+	else if (RunFireTrace(MuzzleLocation, Direction, Hit))
+	{
+		bWillProbablyCauseDamage = Hit.Actor.IsValid() && Hit.Actor->CanBeDamaged();
+		PlayImpactEffects(Hit.ImpactPoint, Hit.ImpactNormal, bWillProbablyCauseDamage);
+	}
+
+	// Shots too old to be covered by acknowledgements are forgotten, neither confirmed nor rolled back
+	if (PredictedShots.Num() >= FHoloFireAck::NumOutcomes)
+	{
+		PredictedShots.RemoveAt(0, 1, false);
+	}
+	PredictedShots.Add({ Command.Sequence, bWillProbablyCauseDamage });
+
+	if (bWillProbablyCauseDamage)
+	{
+		NotifyHitFeedback(Command.Sequence, EHoloHitFeedback::Predicted);
 	}
 }
 
-bool AHoloWeapon::CanFire() const
+bool AHoloWeapon::FlushFireCommands(FHoloFireCommandPacket& OutPacket)
 {
+	if (PendingFireCommands.Num() == 0)
+	{
+		return false;
+	}
+
+	// Without new shots, only resend the unacknowledged ones every now and then
 	const float CurrentTime = GetWorld()->GetTimeSeconds();
-	const float ElapsedSinceLastFire = CurrentTime - LastFireTime;
-	return bAimLocationIsValid && ElapsedSinceLastFire >= FireCooldown;
+	if (!bHasNewFireCommands && CurrentTime - LastFireCommandsSendTime < FireCommandResendInterval)
+	{
+		return false;
+	}
+
+	// Give up on commands the server would reject anyway
+	const float ServerWorldTime = GetServerWorldTime();
+	while (PendingFireCommands.Num() > 0 && ServerWorldTime - PendingFireCommands[0].ClientFireTime > MaxFireCommandAge)
+	{
+		PendingFireCommands.RemoveAt(0, 1, false);
+	}
+
+	bHasNewFireCommands = false;
+	LastFireCommandsSendTime = CurrentTime;
+
+	OutPacket.Commands.Reset();
+	OutPacket.Commands.Append(PendingFireCommands.GetData(), PendingFireCommands.Num());
+	return OutPacket.Commands.Num() > 0;
 }
 
-void AHoloWeapon::PlayFireEffects() const
+bool AHoloWeapon::Auth_ReceiveFireCommands(const FHoloFireCommandPacket& Packet, FHoloFireAck& OutAck)
 {
-	if (!GetOwner())
+	checkf(HasAuthority(), TEXT("AHoloWeapon::Auth_ReceiveFireCommands called on client"));
+
+	const float ServerWorldTime = GetServerWorldTime();
+	for (FHoloFireCommand Command : Packet.Commands)
 	{
-		return;
+		// Skip the redundant copies of commands we've already processed
+		if (bHasProcessedFireCommand && !FHoloFireCommand::IsSequenceNewer(Command.Sequence, LastProcessedFireSequence))
+		{
+			continue;
+		}
+
+		// Shift the outcomes by the number of sequences we moved forward: skipped commands count as misses
+		const uint16 SequenceDelta = bHasProcessedFireCommand ? static_cast<uint16>(Command.Sequence - LastProcessedFireSequence) : FHoloFireAck::NumOutcomes;
+		ConfirmedDamageMask = SequenceDelta < FHoloFireAck::NumOutcomes ? static_cast<uint16>(ConfirmedDamageMask << SequenceDelta) : 0;
+
+		LastProcessedFireSequence = Command.Sequence;
+		bHasProcessedFireCommand = true;
+
+		// Only the low bits of the fire time were sent: it can't be more than a few seconds away from now
+		Command.ClientFireTime = HoloNet::UnwrapPackedTime(Command.ClientFireTime, ServerWorldTime);
+		if (Auth_ProcessFireCommand(Command))
+		{
+			ConfirmedDamageMask |= 1;
+		}
 	}
-	
-	if (FireEffect)
+
+	OutAck.Sequence = LastProcessedFireSequence;
+	OutAck.DamageMask = ConfirmedDamageMask;
+	return bHasProcessedFireCommand;
+}
+
+void AHoloWeapon::AcknowledgeFireCommands(const FHoloFireAck& Ack)
+{
+	while (PendingFireCommands.Num() > 0 && !FHoloFireCommand::IsSequenceNewer(PendingFireCommands[0].Sequence, Ack.Sequence))
 	{
-		UGameplayStatics::SpawnEmitterAttached(FireEffect, MuzzleHandle);
+		PendingFireCommands.RemoveAt(0, 1, false);
 	}
 
-	if (FireSound)
+	// Reconcile our predictions with what the server decided
+	while (PredictedShots.Num() > 0 && !FHoloFireCommand::IsSequenceNewer(PredictedShots[0].Sequence, Ack.Sequence))
 	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, MuzzleHandle->GetComponentLocation(), MuzzleHandle->GetComponentRotation());
+		const FPredictedShot Shot = PredictedShots[0];
+		PredictedShots.RemoveAt(0, 1, false);
+
+		if (Ack.CausedDamage(Shot.Sequence))
+		{
+			NotifyHitFeedback(Shot.Sequence, EHoloHitFeedback::Confirmed);
+		}
+		else if (Shot.bPredictedDamage)
+		{
+			NotifyHitFeedback(Shot.Sequence, EHoloHitFeedback::RolledBack);
+		}
 	}
+}
+
+void AHoloWeapon::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	const FSoftObjectPath Assets[] =
+	{
+		FireEffect.ToSoftObjectPath(),
+		ImpactEffect.ToSoftObjectPath(),
+		ProjectileTrailEffect.ToSoftObjectPath(),
+		ExplosionEffect.ToSoftObjectPath(),
+		FireSound.ToSoftObjectPath(),
+		DamagingImpactSound.ToSoftObjectPath(),
+		NonDamagingImpactSound.ToSoftObjectPath(),
+		FireCameraShake.ToSoftObjectPath(),
+	};
+
+	for (const FSoftObjectPath& Asset : Assets)
+	{
+		if (Asset.IsValid())
+		{
+			OutAssets.AddUnique(Asset);
+		}
+	}
+}
+
+bool AHoloWeapon::GetHitMarker(float& OutAge, bool& bOutConfirmed) const
+{
+	if (HitMarkerFeedback == EHoloHitFeedback::RolledBack)
+	{
+		return false;
+	}
+
+	OutAge = GetWorld()->GetTimeSeconds() - HitMarkerTime;
+	bOutConfirmed = HitMarkerFeedback == EHoloHitFeedback::Confirmed;
+	return true;
+}
+
+void AHoloWeapon::NotifyHitFeedback(uint16 ShotSequence, EHoloHitFeedback Feedback)
+{
+	if (Feedback == EHoloHitFeedback::Predicted || ShotSequence != HitMarkerSequence || HitMarkerFeedback == EHoloHitFeedback::RolledBack)
+	{
+		// A new hit marker, possibly a late one for a hit we didn't predict
+		if (Feedback != EHoloHitFeedback::RolledBack)
+		{
+			HitMarkerSequence = ShotSequence;
+			HitMarkerTime = GetWorld()->GetTimeSeconds();
+			HitMarkerFeedback = Feedback;
+		}
+	}
+	else
+	{
+		// Confirmation or roll back of the hit marker being shown
+		HitMarkerFeedback = Feedback;
+	}
+
+	OnHitFeedbackDelegate.Broadcast(ShotSequence, Feedback);
+}
+
+bool AHoloWeapon::CanFire() const
+{
+	const AHoloPawn* OwnerPawn = Cast<AHoloPawn>(GetOwner());
+	return bAimLocationIsValid && OwnerPawn && !OwnerPawn->bIsDying;
+}
+
+void AHoloWeapon::PlayFireEffects() const
+{
+#if WITH_HOLO_COSMETICS
+	UHoloEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UHoloEffectPoolSubsystem>();
+	if (!GetOwner() || !EffectPool || !Holo::ShouldPlayCosmetics(this))
+	{
+		return;
+	}
+	
+	EffectPool->SpawnEmitterAttached(FireEffect.Get(), MuzzleHandle);
+	EffectPool->PlaySoundAtLocation(FireSound.Get(), MuzzleHandle->GetComponentLocation(), MuzzleHandle->GetComponentRotation());
 
 	AHoloPlayerController* PC = Cast<AHoloPlayerController>(GetOwner()->GetInstigatorController());
-	if (FireCameraShake && PC && PC->IsLocalController())
+	TSubclassOf<UCameraShakeBase> CameraShake = FireCameraShake.Get();
+	if (CameraShake && PC && PC->IsLocalController())
 	{
-		PC->ClientStartCameraShake(FireCameraShake);
+		PC->ClientStartCameraShake(CameraShake);
 	}
+#endif
 }
 
 void AHoloWeapon::PlayImpactEffects(const FVector& ImpactPoint, const FVector& ImpactNormal, bool bCausedDamage)
 {
-	const FRotator ImpactRotation = ImpactNormal.ToOrientationRotator();
-
-	if (ImpactEffect)
+#if WITH_HOLO_COSMETICS
+	UHoloEffectPoolSubsystem* EffectPool = GetWorld()->GetSubsystem<UHoloEffectPoolSubsystem>();
+	if (!EffectPool || !Holo::ShouldPlayCosmetics(this))
 	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), FireEffect, ImpactPoint, ImpactRotation);
+		return;
 	}
 
-	USoundBase* Sound = bCausedDamage ? DamagingImpactSound : NonDamagingImpactSound;
-	if (Sound)
+	const FRotator ImpactRotation = ImpactNormal.ToOrientationRotator();
+	EffectPool->SpawnEmitterAtLocation(ImpactEffect.Get(), ImpactPoint, ImpactRotation);
+	if (bExplodesOnImpact)
 	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), Sound, ImpactPoint, ImpactRotation);
+		EffectPool->SpawnEmitterAtLocation(ExplosionEffect.Get(), ImpactPoint, ImpactRotation);
 	}
+	EffectPool->PlaySoundAtLocation(bCausedDamage ? DamagingImpactSound.Get() : NonDamagingImpactSound.Get(), ImpactPoint, ImpactRotation);
+#endif
 }
 
-bool AHoloWeapon::RunFireTrace(FHitResult& OutHit)
+bool AHoloWeapon::RunFireTrace(const FVector& TraceStart, const FVector& Direction, FHitResult& OutHit) const
 {
-	const FVector& TraceStart = MuzzleHandle->GetComponentLocation();
-	const FVector TraceEnd = TraceStart + (MuzzleHandle->GetForwardVector() * AimTraceDistance);
+	HOLO_SCOPED_TIMING(RunFireTrace);
+
+	const FVector TraceEnd = TraceStart + (Direction * AimTraceDistance);
 	const FName ProfileName = UCollisionProfile::BlockAllDynamic_ProfileName;
 	const FCollisionQueryParams QueryParams(TEXT("WeaponFire"), false, GetOwner());
 	return GetWorld()->LineTraceSingleByProfile(OutHit, TraceStart, TraceEnd, ProfileName, QueryParams);
 }
 
-void AHoloWeapon::OnRep_HitNotify()
+bool AHoloWeapon::Auth_RunFireTrace(const FVector& TraceStart, const FVector& Direction, float ClientFireTime, FHitResult& OutHit) const
+{
+	UHoloLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UHoloLagCompensationSubsystem>();
+	if (!LagCompensation)
+	{
+		return RunFireTrace(TraceStart, Direction, OutHit);
+	}
+
+	HOLO_SCOPED_TIMING(AuthRunFireTrace);
+
+	const FVector TraceEnd = TraceStart + (Direction * AimTraceDistance);
+	const FName ProfileName = UCollisionProfile::BlockAllDynamic_ProfileName;
+	const FCollisionQueryParams QueryParams(TEXT("WeaponFire"), false, GetOwner());
+	const float RewindTime = LagCompensation->GetRewindTime(ClientFireTime);
+	return LagCompensation->LineTraceAtTime(OutHit, TraceStart, TraceEnd, ProfileName, QueryParams, RewindTime);
+}
+
+void AHoloWeapon::OnHitEventReceived(const FInstantHitInfo& HitInfo)
 {
+	// The whole log is received when the weapon becomes relevant: don't replay shots that happened a while ago
+	const float ServerFireTime = HoloNet::UnwrapPackedTime(HitInfo.ServerFireTime, GetServerWorldTime());
+	if (GetServerWorldTime() - ServerFireTime > MaxHitEventAge)
+	{
+		return;
+	}
+
 	PlayFireEffects();
 
-	if (!HitNotify.ImpactNormal.IsZero())
+	if (!HitInfo.ImpactNormal.IsZero())
 	{
-		PlayImpactEffects(HitNotify.ImpactPoint, HitNotify.ImpactNormal, HitNotify.bCausedDamage);
+		PlayImpactEffects(HitInfo.ImpactPoint, HitInfo.ImpactNormal, HitInfo.bCausedDamage);
 	}
 }
 
-void AHoloWeapon::Server_TryFire_Implementation(const FVector& MuzzleLocation, const FVector& Direction)
+bool AHoloWeapon::Auth_ProcessFireCommand(const FHoloFireCommand& Command)
 {
+	HOLO_SCOPED_TIMING(ProcessFireCommand);
+
+	// Commands arrive in bursts after packet loss, so the cooldown is checked against the time the client fired them.
+	// Fire times can't be in the future, too old, or go backwards, which bounds how many shots a client can bank.
 	const float CurrentTime = GetWorld()->GetTimeSeconds();
-	const float ElapsedSinceLastFire = CurrentTime - LastFireTime;
-	if (ElapsedSinceLastFire < FireCooldown)
+	const float FireTime = FMath::Min(Command.ClientFireTime, CurrentTime);
+	if (CurrentTime - FireTime > MaxFireCommandAge
+		|| FireTime < NextClientFireTime - HoloWeapon::FireTimeTolerance)
 	{
-		return;
+		HOLO_INC_COUNTER(FireCommandsRejected, 1);
+		return false;
 	}
 
-	LastFireTime = CurrentTime;
+	// The muzzle is sent relative to the shooter's pawn, whose location the server already knows from movement replication
+	const FVector ServerMuzzleLocation = MuzzleHandle->GetComponentLocation();
+	const FVector ClientMuzzleLocation = GetOwner()->GetActorLocation() + Command.MuzzleOffset;
+	const FVector TraceDirection = Command.Direction.IsNearlyZero() ? MuzzleHandle->GetForwardVector() : Command.Direction.GetSafeNormal();
+
+	// Shots fired from nowhere near our muzzle, or away from where the player is looking, are cheats rather than lag
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	UHoloFireValidationSubsystem* FireValidation = GetWorld()->GetSubsystem<UHoloFireValidationSubsystem>();
+	if (FireValidation && !FireValidation->Auth_ValidateShot(OwnerPawn ? OwnerPawn->GetController<APlayerController>() : nullptr, ClientMuzzleLocation, ServerMuzzleLocation, TraceDirection))
+	{
+		HOLO_INC_COUNTER(FireCommandsRejected, 1);
+		return false;
+	}
+
+	HOLO_INC_COUNTER(FireCommandsProcessed, 1);
+
+	// A shot accepted a bit early doesn't bring the next one forward: at most one cooldown per shot on average
+	NextClientFireTime = FMath::Max(FireTime, NextClientFireTime) + FireCooldown;
+
+	if (AHoloPawn* HoloPawn = Cast<AHoloPawn>(GetOwner()))
+	{
+		HoloPawn->Auth_NotifyCombatActivity();
+	}
+
+	// Trace from where the client saw its muzzle, as long as it roughly agrees with ours
+	const bool bMuzzleIsPlausible = FVector::DistSquared(ClientMuzzleLocation, ServerMuzzleLocation) <= FMath::Square(MaxMuzzleLocationError);
+	const FVector TraceStart = bMuzzleIsPlausible ? ClientMuzzleLocation : ServerMuzzleLocation;
+
+	// Projectiles only replicate their spawn, through the shooter's pawn since the weapon is dormant; they deal their damage later on
+	if (bFiresProjectiles)
+	{
+		FHoloProjectileSpawn Spawn;
+		Spawn.Origin = TraceStart;
+		Spawn.Direction = TraceDirection;
+		Spawn.Seed = Command.Sequence;
+		Spawn.ServerSpawnTime = FireTime;
+
+		PlayFireEffects();
+		LaunchProjectile(Spawn, FireTime, true);
+
+		if (AHoloPawn* HoloPawn = Cast<AHoloPawn>(GetOwner()))
+		{
+			HoloPawn->Multicast_SpawnProjectile(Spawn);
+		}
+		return false;
+	}
+
+	// A zero ImpactNormal is used as a sentinel to indicate that this shot didn't hit anything
+	FInstantHitInfo HitInfo;
+	HitInfo.ServerFireTime = CurrentTime;
 
 	FHitResult Hit;
-	if (RunFireTrace(Hit))
+	if (Auth_RunFireTrace(TraceStart, TraceDirection, FireTime, Hit))
 	{
 		// If we hit a damageable actor, attempt to damage it
 		float DamageCaused = 0.0f;
 		if (Hit.Actor.IsValid() && Hit.Actor->CanBeDamaged())
 		{
-			const FPointDamageEvent DamageEvent(BaseDamage, Hit, Direction, UDamageType::StaticClass());
+			const FPointDamageEvent DamageEvent(BaseDamage, Hit, TraceDirection, UDamageType::StaticClass());
 			DamageCaused = Hit.Actor->TakeDamage(BaseDamage, DamageEvent, GetInstigatorController(), this);
 		}
+		Auth_Explode(Hit.ImpactPoint, Hit.ImpactNormal);
 		
 		PlayFireEffects();
 		PlayImpactEffects(Hit.ImpactPoint, Hit.ImpactNormal, DamageCaused > 0.0f);
 
-		// Propagate the details of our hit to non-owning clients
-		HitNotify.bCausedDamage = DamageCaused > 0.0f;
-		HitNotify.ImpactPoint = Hit.ImpactPoint;
-		HitNotify.ImpactNormal = Hit.ImpactNormal;
+		HitInfo.bCausedDamage = DamageCaused > 0.0f;
+		HitInfo.ImpactPoint = Hit.ImpactPoint;
+		HitInfo.ImpactNormal = Hit.ImpactNormal;
 	}
-	else
+
+	// Propagate the details of our shot to non-owning clients: wake the weapon up for a single update, it goes back to sleep on its own
+	FlushNetDormancy();
+	HitEvents.AddEvent(HitInfo, MaxHitEvents);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHoloWeapon, HitEvents, this);
+
+	return HitInfo.bCausedDamage;
+}
+
+void AHoloWeapon::LaunchProjectile(const FHoloProjectileSpawn& Spawn, float LocalSpawnTime, bool bAuthoritative)
+{
+	if (UHoloProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UHoloProjectileSubsystem>())
+	{
+		ProjectileSubsystem->SpawnProjectile(this, Spawn, LocalSpawnTime, bAuthoritative);
+	}
+}
+
+void AHoloWeapon::OnProjectileImpact(const FHitResult& Hit, const FVector& Direction, bool bAuthoritative)
+{
+	bool bCausedDamage = false;
+	const bool bCanBeDamaged = Hit.Actor.IsValid() && Hit.Actor->CanBeDamaged();
+	if (bAuthoritative && bCanBeDamaged)
+	{
+		const FPointDamageEvent DamageEvent(BaseDamage, Hit, Direction, UDamageType::StaticClass());
+		bCausedDamage = Hit.Actor->TakeDamage(BaseDamage, DamageEvent, GetInstigatorController(), this) > 0.0f;
+	}
+	if (bAuthoritative)
+	{
+		Auth_Explode(Hit.ImpactPoint, Hit.ImpactNormal);
+	}
+
+	// Clients can only guess whether their copy of the projectile caused damage
+	PlayImpactEffects(Hit.ImpactPoint, Hit.ImpactNormal, bAuthoritative ? bCausedDamage : bCanBeDamaged);
+}
+
+void AHoloWeapon::Auth_Explode(const FVector& ImpactPoint, const FVector& ImpactNormal)
+{
+	checkf(HasAuthority(), TEXT("AHoloWeapon::Auth_Explode called on client"));
+
+	if (!bExplodesOnImpact)
 	{
-		// Set ImpactNormal to zero as a sentinel to indicate that this shot didn't hit anything
-		HitNotify.ImpactNormal = FVector::ZeroVector;
+		return;
 	}
+
+	// Every explosion of the frame is resolved in a single batch
+	if (UHoloAreaDamageSubsystem* AreaDamage = GetWorld()->GetSubsystem<UHoloAreaDamageSubsystem>())
+	{
+		const FVector Origin = ImpactPoint + ImpactNormal * HoloWeapon::ExplosionSurfaceOffset;
+		AreaDamage->Auth_QueueExplosion(Origin, ExplosionDamage, GetInstigatorController(), this);
+	}
+}
+
+void AHoloWeapon::OnProjectileSpawnReceived(const FHoloProjectileSpawn& Spawn)
+{
+	// Convert the server time of the shot to our own clock, the projectile is fast-forwarded to catch up
+	const float ServerWorldTime = GetServerWorldTime();
+	const float ServerSpawnTime = HoloNet::UnwrapPackedTime(Spawn.ServerSpawnTime, ServerWorldTime);
+	const float LocalSpawnTime = GetWorld()->GetTimeSeconds() - (ServerWorldTime - ServerSpawnTime);
+
+	PlayFireEffects();
+	LaunchProjectile(Spawn, LocalSpawnTime, false);
+}
+
+float AHoloWeapon::GetServerWorldTime() const
+{
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
 }
 
 void AHoloWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION(AHoloWeapon, HitNotify, COND_SkipOwner);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHoloWeapon, HitEvents, Params);
 }
@@ -0,0 +1,157 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapons/HoloWeaponRotationSubsystem.h"
+
+#include "Holo.h"
+#include "Weapons/HoloWeapon.h"
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Rotations Update"), STAT_HoloWeaponRotationsUpdate, STATGROUP_Holo);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Rotations Applied"), STAT_HoloWeaponRotationsApplied, STATGROUP_Holo);
+
+void UHoloWeaponRotationSubsystem::Tick(float DeltaTime)
+{
+	const int32 NumWeapons = Weapons.Num();
+	if (NumWeapons == 0)
+	{
+		return;
+	}
+
+	HOLO_SCOPED_TIMING(WeaponRotationsUpdate);
+
+	CurrentRotations.SetNumUninitialized(NumWeapons, false);
+	TargetRotations.SetNumUninitialized(NumWeapons, false);
+	NewRotations.SetNumUninitialized(NumWeapons, false);
+	InterpAlphas.SetNumUninitialized(NumWeapons, false);
+
+	// Gather the current state and figure out where each weapon should be pointing
+	for (int32 Index = 0; Index < NumWeapons; ++Index)
+	{
+		const AHoloWeapon* Weapon = Weapons[Index];
+		const USceneComponent* Root = Weapon ? Weapon->GetRootComponent() : nullptr;
+		if (!Root || !RotationsEnabled[Index])
+		{
+			// Frozen weapons interpolate toward their current rotation, which leaves them untouched
+			const FQuat Rotation = Root ? Root->GetComponentQuat() : FQuat::Identity;
+			CurrentRotations[Index] = Rotation;
+			TargetRotations[Index] = Rotation;
+			InterpAlphas[Index] = 0.0f;
+			continue;
+		}
+
+		CurrentRotations[Index] = Root->GetComponentQuat();
+
+		float InterpSpeed;
+		if (AimLocationsValid[Index])
+		{
+			// Aiming at the target
+			TargetRotations[Index] = (AimLocations[Index] - Root->GetComponentLocation()).ToOrientationQuat();
+			InterpSpeed = AimInterpSpeeds[Index];
+		}
+		else
+		{
+			// Rotate the weapon to the side
+			const AActor* AttachParent = Weapon->GetAttachParentActor();
+			TargetRotations[Index] = AttachParent ? AttachParent->GetActorQuat() * DropRotations[Index] : DropRotations[Index];
+			InterpSpeed = DropInterpSpeeds[Index];
+		}
+
+		// Same as FMath::RInterpTo/QInterpTo: a non-positive speed snaps to the target
+		InterpAlphas[Index] = InterpSpeed > 0.0f ? FMath::Clamp(DeltaTime * InterpSpeed, 0.0f, 1.0f) : 1.0f;
+	}
+
+	// Interpolate all rotations at once (normalized lerp along the shortest arc)
+	const VectorRegister Zero = VectorZero();
+	for (int32 Index = 0; Index < NumWeapons; ++Index)
+	{
+		const VectorRegister Current = VectorLoad(&CurrentRotations[Index]);
+		VectorRegister Target = VectorLoad(&TargetRotations[Index]);
+		const VectorRegister Alpha = VectorLoadFloat1(&InterpAlphas[Index]);
+
+		const VectorRegister ShortestArcMask = VectorCompareLT(VectorDot4(Current, Target), Zero);
+		Target = VectorSelect(ShortestArcMask, VectorNegate(Target), Target);
+
+		const VectorRegister Blended = VectorMultiplyAdd(VectorSubtract(Target, Current), Alpha, Current);
+		VectorStore(VectorNormalizeQuaternion(Blended), &NewRotations[Index]);
+	}
+
+	// Only move the weapons whose rotation actually changed
+	int32 NumApplied = 0;
+	for (int32 Index = 0; Index < NumWeapons; ++Index)
+	{
+		if (InterpAlphas[Index] > 0.0f && !NewRotations[Index].Equals(CurrentRotations[Index], KINDA_SMALL_NUMBER))
+		{
+			Weapons[Index]->GetRootComponent()->SetWorldRotation(NewRotations[Index]);
+			++NumApplied;
+		}
+	}
+
+	HOLO_INC_COUNTER(WeaponRotationsApplied, NumApplied);
+}
+
+TStatId UHoloWeaponRotationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHoloWeaponRotationSubsystem, STATGROUP_Tickables);
+}
+
+void UHoloWeaponRotationSubsystem::RegisterWeapon(AHoloWeapon* Weapon)
+{
+	check(Weapon);
+
+	if (Weapon->RotationSlot != INDEX_NONE)
+	{
+		return;
+	}
+
+	Weapon->RotationSlot = Weapons.Add(Weapon);
+	AimLocations.Add(Weapon->AimLocation);
+	AimLocationsValid.Add(Weapon->bAimLocationIsValid);
+	RotationsEnabled.Add(true);
+	AimInterpSpeeds.Add(Weapon->AimInterpSpeed);
+	DropInterpSpeeds.Add(Weapon->DropInterpSpeed);
+	DropRotations.Add(FQuat(Weapon->DropRotation));
+}
+
+void UHoloWeaponRotationSubsystem::UnregisterWeapon(AHoloWeapon* Weapon)
+{
+	const int32 Slot = Weapon ? Weapon->RotationSlot : INDEX_NONE;
+	if (!Weapons.IsValidIndex(Slot) || Weapons[Slot] != Weapon)
+	{
+		return;
+	}
+
+	Weapons.RemoveAtSwap(Slot, 1, false);
+	AimLocations.RemoveAtSwap(Slot, 1, false);
+	AimLocationsValid.RemoveAtSwap(Slot, 1, false);
+	RotationsEnabled.RemoveAtSwap(Slot, 1, false);
+	AimInterpSpeeds.RemoveAtSwap(Slot, 1, false);
+	DropInterpSpeeds.RemoveAtSwap(Slot, 1, false);
+	DropRotations.RemoveAtSwap(Slot, 1, false);
+
+	// The last weapon took the freed slot
+	if (Weapons.IsValidIndex(Slot) && Weapons[Slot])
+	{
+		Weapons[Slot]->RotationSlot = Slot;
+	}
+
+	Weapon->RotationSlot = INDEX_NONE;
+}
+
+void UHoloWeaponRotationSubsystem::SetAimTarget(const AHoloWeapon* Weapon, const FVector& AimLocation, bool bAimLocationIsValid)
+{
+	const int32 Slot = Weapon->RotationSlot;
+	if (Weapons.IsValidIndex(Slot))
+	{
+		AimLocations[Slot] = AimLocation;
+		AimLocationsValid[Slot] = bAimLocationIsValid;
+	}
+}
+
+void UHoloWeaponRotationSubsystem::SetRotationEnabled(const AHoloWeapon* Weapon, bool bEnabled)
+{
+	const int32 Slot = Weapon->RotationSlot;
+	if (Weapons.IsValidIndex(Slot))
+	{
+		RotationsEnabled[Slot] = bEnabled;
+	}
+}
@@ -0,0 +1,79 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HoloAssetPreloadSubsystem.generated.h"
+
+class AHoloGameMode;
+struct FStreamableHandle;
+
+/**
+ * Streams in, asynchronously, the content needed during the game, as soon as the map is loaded. Weapons and pawns only
+ * hold soft references to their classes, effects and sounds, so none of it is loaded synchronously along with them or
+ * on first use. Game content is preloaded in two steps:
+ * - the game mode's PreloadAssets, and the classes referenced by its default pawn (weapon, widgets);
+ * - once the weapon class is in, its effects and sounds, whose effect pools are then prewarmed.
+ * Shader pipeline states are precompiled at full speed until everything requested is loaded, and in the background after.
+ * Started on the server and on every client by AHoloGameState, as soon as the game mode class is known.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloAssetPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/** Preloads the content the players of the game mode will need. */
+	void PreloadGameContent(const AHoloGameMode* GameMode);
+
+	/**
+	 * Loads the assets asynchronously, skipping those already loaded. Particle systems among them get their effect pools
+	 * prewarmed once loaded.
+	 * @param OnLoaded - Called once all the assets are loaded, right away if they already are
+	 */
+	void RequestPreload(const TArray<FSoftObjectPath>& Assets, FSimpleDelegate OnLoaded = FSimpleDelegate());
+
+	/** Returns the fraction of the requested assets that are loaded, between 0 and 1. */
+	float GetProgress() const;
+
+	bool IsPreloading() const { return bPreloading; }
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnPreloadProgress, float /*Progress*/);
+
+	/**
+	 * Broadcast as the requested assets load, e.g. to drive a loading screen; 1 once they're all loaded.
+	 * Progress may go back when loaded content brings in more assets to load.
+	 */
+	FOnPreloadProgress OnPreloadProgressDelegate;
+
+protected:
+
+	/** Pooled components created up front for each preloaded particle system, so the first shots don't create them. */
+	UPROPERTY(Config)
+	int32 PrewarmedComponentsPerEffect = 2;
+
+private:
+
+	/** Every request made, kept for the lifetime of the world: nothing else references the preloaded content until it's used. */
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+
+	/** Whether some of the requests are still loading. */
+	bool bPreloading = false;
+
+	/** Time the preload started, i.e. the first request made while nothing was loading. */
+	double PreloadStartTime = 0.0;
+
+	void OnRequestLoaded(TArray<FSoftObjectPath> Assets, FSimpleDelegate OnLoaded);
+	void OnRequestUpdated(TSharedRef<FStreamableHandle> Handle);
+	void PrewarmEffects(const TArray<FSoftObjectPath>& Assets) const;
+
+	/** Broadcasts the progress, and wraps up the preload once every request is loaded. */
+	void UpdateProgress();
+};
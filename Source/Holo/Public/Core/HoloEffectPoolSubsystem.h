@@ -0,0 +1,125 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "HoloEffectPoolSubsystem.generated.h"
+
+class UAudioComponent;
+class UParticleSystem;
+class UParticleSystemComponent;
+class USoundBase;
+
+/**
+ * Components created for a single particle system. The first inactive one is reused; once they're all active, the pool
+ * grows up to MaxComponentsPerEffect, then the least recently activated one is restarted.
+ */
+USTRUCT()
+struct FHoloParticleEffectPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<UParticleSystemComponent*> Components;
+
+	/** World time at which each component was last (re)activated, used to steal the least recently used one. */
+	TArray<float> LastUseTimes;
+};
+
+/**
+ * Components created for a single sound. The first one not playing is reused; once they're all playing, the pool grows
+ * up to MaxComponentsPerEffect, then the least recently played one is restarted.
+ */
+USTRUCT()
+struct FHoloAudioEffectPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<UAudioComponent*> Components;
+
+	/** World time at which each component was last played, used to steal the least recently used one. */
+	TArray<float> LastUseTimes;
+};
+
+/**
+ * Plays short-lived cosmetic effects (muzzle flashes, impacts and their sounds) from pools of reusable components,
+ * so that firing doesn't allocate a new component per shot.
+ *
+ * Each effect asset gets at most MaxComponentsPerEffect components: once they're all busy, the least recently used one is restarted.
+ * Effects too far from the local viewer, or over the per-frame budget, are simply skipped.
+ * Never created on dedicated servers.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloEffectPoolSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	 * Plays the particle system at the given location.
+	 * @returns the component playing it, until it completes or is restarted for another use; null if the effect was skipped
+	 */
+	UParticleSystemComponent* SpawnEmitterAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation);
+
+	/** Plays the particle system attached to the given component. */
+	void SpawnEmitterAttached(UParticleSystem* Template, USceneComponent* AttachToComponent);
+
+	/** Plays the sound at the given location. */
+	void PlaySoundAtLocation(USoundBase* Sound, const FVector& Location, const FRotator& Rotation);
+
+	/** Creates components for the particle system ahead of its first use, up to the given number, so that playing it doesn't hitch. */
+	void PrewarmEmitter(UParticleSystem* Template, int32 NumComponents);
+
+protected:
+
+	/** Maximum number of components kept per effect asset. */
+	UPROPERTY(Config)
+	int32 MaxComponentsPerEffect = 12;
+
+	/** Maximum number of effects (particles and sounds) started per frame, anything past it is dropped. */
+	UPROPERTY(Config)
+	int32 MaxEffectsPerFrame = 24;
+
+	/** Particle effects further than this from the local viewer are not played. */
+	UPROPERTY(Config)
+	float ParticleCullDistance = 8000.0f;
+
+private:
+
+	UPROPERTY(Transient)
+	TMap<UParticleSystem*, FHoloParticleEffectPool> ParticlePools;
+
+	UPROPERTY(Transient)
+	TMap<USoundBase*, FHoloAudioEffectPool> AudioPools;
+
+	/** Location of the local viewer, refreshed every frame. */
+	FVector ViewLocation = FVector::ZeroVector;
+	bool bHasViewLocation = false;
+
+	/** Number of effects started since the last tick. */
+	int32 NumEffectsThisFrame = 0;
+
+	/** Returns false if an effect at this location should be skipped, and consumes some of the frame budget otherwise. */
+	bool ConsumeBudget(const FVector& Location, float CullDistance);
+
+	UParticleSystemComponent* AcquireParticleComponent(UParticleSystem* Template);
+	UParticleSystemComponent* CreateParticleComponent(UParticleSystem* Template);
+	UAudioComponent* AcquireAudioComponent(USoundBase* Sound);
+
+	/** Returns the slot to use in a pool: a free slot, a new one if there's room left, or the least recently used one. */
+	template<typename ComponentType>
+	int32 FindPoolSlot(const TArray<ComponentType*>& Components, const TArray<float>& LastUseTimes, TFunctionRef<bool(const ComponentType*)> IsBusy) const;
+};
@@ -24,23 +24,47 @@ public:
 	//~ Begin AGameModeBase interface
 	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
 	virtual AActor* FindPlayerStart_Implementation(AController* Player, const FString& IncomingName) override;
+	virtual void RestartPlayerAtPlayerStart(AController* NewPlayer, AActor* StartSpot) override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
 	//~ End AGameModeBase interface
 
 	/** If we're initializing a newly-spawned player pawn, assign it a color */
 	void SetPlayerColor(class AHoloPawn* HoloPawn);
 
+	/**
+	 * Deactivates the pawn of a player leaving the game and keeps it around to be reused by the next player that needs one.
+	 * @returns false if the pool is full, in which case the pawn should be destroyed
+	 */
+	bool Auth_ReleasePawn(class AHoloPawn* HoloPawn);
+
+	const TArray<FSoftObjectPath>& GetPreloadAssets() const { return PreloadAssets; }
+
 protected:
 
 	/** A sequence of arbitrary color values that will be assigned to newly-spawned player pawns. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Players")
 	TArray<FLinearColor> PlayerColors;
 
+	/** Maximum number of pawns (and their weapons) kept for reuse after their player left the game. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Players")
+	int32 MaxPooledPawns;
+
+	/**
+	 * Content streamed in on every machine as soon as the map is loaded, in addition to the default pawn's weapon and widgets.
+	 * See UHoloAssetPreloadSubsystem.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Loading")
+	TArray<FSoftObjectPath> PreloadAssets;
+
 private:
 	
 	/** Index into PlayerColors indicating the last color value we assigned to a pawn. */
 	int32 LastPlayerColorIndex;
 
-	/** Cached start actors */
+	/** Deactivated pawns waiting to be reused */
 	UPROPERTY(Transient)
-	TArray<AActor*> StartActors;
+	TArray<class AHoloPawn*> PooledPawns;
+
+	/** Takes a pawn of the given class out of the pool, if there is one */
+	class AHoloPawn* AcquirePooledPawn(UClass* PawnClass);
 };
@@ -0,0 +1,38 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameState.h"
+#include "HoloGameState.generated.h"
+
+class APlayerState;
+
+UCLASS()
+class HOLO_API AHoloGameState : public AGameState
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin AGameStateBase Interface
+	virtual void ReceivedGameModeClass() override;
+	//~ End AGameStateBase Interface
+
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnKill, APlayerState* /*Killer*/, APlayerState* /*Victim*/);
+
+	/** Broadcast on every machine when a player is killed, e.g. to update kill feeds. */
+	FOnKill OnKillDelegate;
+
+	/**
+	 * Announces a kill to every player. Server/authority only.
+	 * @param Killer - Player who dealt the killing blow, null if it wasn't dealt by a player
+	 */
+	void Auth_NotifyKill(APlayerState* Killer, APlayerState* Victim);
+
+private:
+
+	/** Kills are purely informative for clients: losing one only leaves it out of the kill feed. */
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_NotifyKill(APlayerState* Killer, APlayerState* Victim);
+};
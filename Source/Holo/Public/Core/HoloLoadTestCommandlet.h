@@ -0,0 +1,27 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HoloLoadTestCommandlet.generated.h"
+
+/**
+ * Runs a headless load test: starts a dedicated server recording its performance to a CSV file
+ * (see UHoloLoadTestRecorderSubsystem), then ramps up headless bot clients (-HoloBot) against it.
+ *
+ * UE4Editor-Cmd Holo.uproject -run=HoloLoadTest -Clients=64 -Step=8 -StepInterval=15 -Duration=300 -Csv=LoadTest.csv
+ */
+UCLASS()
+class HOLO_API UHoloLoadTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UHoloLoadTestCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "WorldCollision.h"
+#include "HoloSpawnSelectionSubsystem.generated.h"
+
+class APlayerStart;
+
+/**
+ * Picks where players respawn, away from the action. Player starts are indexed in a 2D grid and continuously scored:
+ * - proximity of living pawns, refreshed a few times per second through the grid;
+ * - how many living pawns can see them, refreshed round-robin with a budget of async line traces per frame;
+ * - how recently they were used, so that players respawning together don't end up on the same spot.
+ * Selecting a start only compares the cached scores, so a wave of respawns costs next to nothing.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloSpawnSelectionSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** [Server] Returns the player start with the lowest danger score, or null if the world has none. */
+	AActor* Auth_SelectPlayerStart(const AController* Player);
+
+protected:
+
+	/** Size of the grid cells player starts are bucketed in. */
+	UPROPERTY(Config)
+	float CellSize = 2000.0f;
+
+	/** Living pawns closer than this to a player start make it less attractive, the closer the worse. */
+	UPROPERTY(Config)
+	float DangerRadius = 3000.0f;
+
+	/** Weight of a pawn standing right on a player start. */
+	UPROPERTY(Config)
+	float ProximityWeight = 1.0f;
+
+	/** Seconds between two updates of the proximity scores. */
+	UPROPERTY(Config)
+	float ProximityUpdateInterval = 0.25f;
+
+	/** Living pawns further than this from a player start aren't checked for line of sight. */
+	UPROPERTY(Config)
+	float LineOfSightRange = 8000.0f;
+
+	/** Weight of each living pawn that can see a player start. */
+	UPROPERTY(Config)
+	float LineOfSightWeight = 2.0f;
+
+	/** Line of sight traces issued per frame. The player starts are refreshed round-robin, at least one per frame. */
+	UPROPERTY(Config)
+	int32 MaxTracesPerFrame = 32;
+
+	/** Height above a player start at which line of sight is checked, roughly where a spawned pawn's head is. */
+	UPROPERTY(Config)
+	float LineOfSightHeight = 60.0f;
+
+	/** Seconds during which a player start that was just used is penalized. */
+	UPROPERTY(Config)
+	float RecentUseTime = 3.0f;
+
+	/** Penalty of a player start that was used this very frame, fading out over RecentUseTime. */
+	UPROPERTY(Config)
+	float RecentUseWeight = 4.0f;
+
+private:
+
+	/** Registered player starts; every other array is indexed the same way. */
+	UPROPERTY(Transient)
+	TArray<APlayerStart*> StartPoints;
+
+	TArray<FVector> StartLocations;
+	TArray<float> ProximityScores;
+	TArray<int32> VisiblePawnCounts;
+	TArray<float> LastUseTimes;
+
+	/** Visible pawns counted by the traces in flight, moved to VisiblePawnCounts once their results are in. */
+	TArray<int32> PendingVisiblePawnCounts;
+
+	/** Player starts whose line of sight traces were issued last frame. */
+	TArray<int32> InFlightStarts;
+
+	/** Indices of the player starts of each grid cell. */
+	TMap<FIntPoint, TArray<int32>> Grid;
+
+	/** View locations of the living pawns, gathered every frame. */
+	TArray<FVector> LivingPawnLocations;
+
+	bool bStartPointsDirty = true;
+	float TimeSinceProximityUpdate = 0.0f;
+	int32 NextLineOfSightStart = 0;
+
+	/** Incremented whenever the player starts are rebuilt, to discard the results of traces issued for the previous ones. */
+	uint32 StartPointsGeneration = 0;
+
+	FTraceDelegate TraceDelegate;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	void OnLevelsChanged(ULevel* Level, UWorld* World);
+	void RebuildStartPoints();
+	void GatherLivingPawns();
+	void UpdateProximityScores();
+	void IssueLineOfSightTraces();
+	void OnLineOfSightTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	FIntPoint GetCell(const FVector& Location) const;
+};
@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HoloTickableWorldSubsystem.generated.h"
+
+/**
+ * Base class for Holo world subsystems that need to run once per frame.
+ * Only created for game worlds, and ticked after all actors of the owning world have ticked.
+ */
+UCLASS(Abstract)
+class HOLO_API UHoloTickableWorldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** Returns true if the owning world runs with authority (standalone, listen or dedicated server). */
+	bool IsServerWorld() const;
+
+private:
+
+	/** Set between Initialize and Deinitialize, so we never tick a half-constructed or torn down subsystem. */
+	bool bInitialized = false;
+};
@@ -3,4 +3,45 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogHolo, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Holo"), STATGROUP_Holo, STATCAT_Advanced);
+
+/** Paints of the Holo widgets this frame: they're retained, so this stays at zero while nothing changes on screen. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Widget Paints"), STAT_HoloWidgetPaints, STATGROUP_Holo, HOLO_API);
+
+/** Gameplay timings and counters in CSV profiler captures (-csvCaptureFrames=N, or csvprofile start/stop). */
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(HOLO_API, Holo);
+
+/** Gameplay scopes in Unreal Insights, enabled with -trace=cpu,Holo. */
+UE_TRACE_CHANNEL_EXTERN(HoloChannel, HOLO_API);
+
+/**
+ * Times the enclosing scope in every profiler at once: "stat Holo" (STAT_Holo<Name> must be declared as a cycle stat),
+ * CSV captures and Unreal Insights. Unlike stats, the last two remain available in Test builds.
+ */
+#define HOLO_SCOPED_TIMING(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Holo##Name); \
+	CSV_SCOPED_TIMING_STAT(Holo, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("Holo_" #Name, HoloChannel)
+
+/** Adds to a per-frame counter, in "stat Holo" (STAT_Holo<Name> must be declared as a DWORD counter stat) and CSV captures. */
+#define HOLO_INC_COUNTER(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_Holo##Name, Amount); \
+	CSV_CUSTOM_STAT(Holo, Name, static_cast<int32>(Amount), ECsvCustomStatOp::Accumulate)
+
+/** Cosmetic-only code paths (effects, sounds, ragdolls, materials) are compiled out of dedicated server builds. */
+#define WITH_HOLO_COSMETICS (!UE_SERVER)
+
+namespace Holo
+{
+	/**
+	 * Returns false if nobody can see or hear the world of the given object, i.e. on dedicated servers,
+	 * including game builds started with -server where cosmetics are compiled in but still useless.
+	 */
+	HOLO_API bool ShouldPlayCosmetics(const UObject* WorldContextObject);
+}
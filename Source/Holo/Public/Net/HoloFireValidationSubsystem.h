@@ -0,0 +1,114 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "HoloFireValidationSubsystem.generated.h"
+
+class AGameModeBase;
+
+/**
+ * Server-side sanity checks of the fire commands sent by clients, on top of the weapon's own cooldown checks:
+ * - fire command packets are rate limited per connection by a token bucket, excess packets are dropped unprocessed;
+ * - shots fired from too far away from the server's muzzle, or too far off the replicated view direction, are rejected;
+ * - players flooding packets or accumulating rejected shots over a sliding window are kicked.
+ * The state of each player is a fixed-size window of counters, and every check costs O(1), so a misbehaving client can't
+ * make validation itself expensive.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloFireValidationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/**
+	 * [Server] Accounts for a fire command packet received from the player.
+	 * @returns false if the packet exceeds the player's rate limit and must be dropped
+	 */
+	bool Auth_ValidatePacket(APlayerController* Player, int32 NumCommands);
+
+	/**
+	 * [Server] Checks that a shot the player claims to have fired is plausible.
+	 * @returns false if the shot must be rejected
+	 */
+	bool Auth_ValidateShot(APlayerController* Player, const FVector& ClientMuzzleLocation, const FVector& ServerMuzzleLocation, const FVector& Direction);
+
+protected:
+
+	/** Fire command packets a player may send per second on average. Clients send at most one per frame. */
+	UPROPERTY(Config)
+	float MaxPacketsPerSecond = 90.0f;
+
+	/** Packets a player may send in a burst above the average rate, e.g. after a hitch. */
+	UPROPERTY(Config)
+	float MaxPacketBurst = 30.0f;
+
+	/** Distance between the client's and the server's muzzle beyond which a shot is rejected. */
+	UPROPERTY(Config)
+	float MaxMuzzleError = 400.0f;
+
+	/** Angle between a shot and the player's replicated view direction beyond which it is rejected. */
+	UPROPERTY(Config)
+	float MaxViewDivergenceAngle = 45.0f;
+
+	/** Duration of each bucket of the sliding window of statistics kept per player. */
+	UPROPERTY(Config)
+	float WindowBucketDuration = 0.5f;
+
+	/** Dropped packets over the sliding window that get a player kicked. */
+	UPROPERTY(Config)
+	int32 KickDroppedPackets = 60;
+
+	/** Rejected shots over the sliding window that get a player kicked. */
+	UPROPERTY(Config)
+	int32 KickRejectedShots = 10;
+
+private:
+
+	/** Number of buckets of the sliding window of statistics. */
+	static constexpr int32 NumWindowBuckets = 8;
+
+	struct FWindowBucket
+	{
+		int32 Packets = 0;
+		int32 Commands = 0;
+		int32 DroppedPackets = 0;
+		int32 RejectedShots = 0;
+	};
+
+	struct FPlayerFireStats
+	{
+		FWindowBucket Buckets[NumWindowBuckets];
+
+		/** Absolute index of the bucket being filled, i.e. time / WindowBucketDuration. */
+		int64 CurrentBucket = 0;
+
+		float PacketTokens = 0.0f;
+		float LastPacketTime = 0.0f;
+		bool bKicked = false;
+	};
+
+	TMap<TObjectKey<APlayerController>, FPlayerFireStats> PlayerStats;
+
+	/** Cosine of MaxViewDivergenceAngle. */
+	float MinViewDot = 0.0f;
+
+	FDelegateHandle LogoutHandle;
+
+	void OnLogout(AGameModeBase* GameMode, AController* Exiting);
+
+	/** Returns the stats of the player, with the sliding window advanced to the current time. */
+	FPlayerFireStats& GetPlayerStats(APlayerController* Player, float CurrentTime);
+
+	/** Kicks the player if its sliding window exceeds one of the limits. */
+	void CheckForKick(APlayerController* Player, FPlayerFireStats& Stats);
+};
@@ -0,0 +1,114 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "HoloLagCompensationSubsystem.generated.h"
+
+class AHoloPawn;
+
+/**
+ * Server-side lag compensation for hitscan weapons.
+ *
+ * Every server frame the location of each registered pawn is recorded into a fixed-size ring buffer.
+ * Samples are stored sample-major (all pawns of one frame are contiguous), so recording is a single linear
+ * write and a rewind only needs to locate the bracketing samples once per shot, no matter how many pawns are tracked.
+ * Nothing is allocated after Initialize.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloLagCompensationSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Maximum number of pawns that can be tracked at the same time. */
+	static constexpr int32 MaxTrackedPawns = 128;
+
+	/** Number of samples kept per pawn: a little over one second of history at 60Hz. */
+	static constexpr int32 HistoryLength = 64;
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Starts recording the history of the given pawn. Server only. */
+	void RegisterPawn(AHoloPawn* Pawn);
+
+	/** Stops recording the history of the given pawn and frees its slot. */
+	void UnregisterPawn(AHoloPawn* Pawn);
+
+	/** Drops the recorded history of the given pawn, e.g. after it has been teleported. */
+	void ResetPawnHistory(AHoloPawn* Pawn);
+
+	/**
+	 * Converts a client fire timestamp into the server time that should be used to rewind targets.
+	 * @param ClientFireTime - Server world time as seen by the client when it fired (AGameStateBase::GetServerWorldTimeSeconds)
+	 */
+	float GetRewindTime(float ClientFireTime) const;
+
+	/**
+	 * Runs a line trace against the world with every pawn that could be hit moved back to where it was at RewindTime.
+	 * Pawns are restored to their current location before this function returns.
+	 */
+	bool LineTraceAtTime(FHitResult& OutHit, const FVector& Start, const FVector& End, FName ProfileName, const FCollisionQueryParams& Params, float RewindTime);
+
+protected:
+
+	/** The furthest back in time we're willing to rewind targets, in seconds. Protects targets from players with a very high latency. */
+	UPROPERTY(Config)
+	float MaxRewindTime = 0.3f;
+
+	/** Extra radius added to the bounds of each pawn during the broad-phase, to absorb interpolation error. */
+	UPROPERTY(Config)
+	float BroadPhaseMargin = 20.0f;
+
+private:
+
+	/** Pawn tracked in each slot; null if the slot is free. */
+	TArray<TWeakObjectPtr<AHoloPawn>, TFixedAllocator<MaxTrackedPawns>> TrackedPawns;
+
+	/** Radius of a sphere bounding the collision of the pawn in each slot. */
+	TArray<float, TFixedAllocator<MaxTrackedPawns>> BoundsRadii;
+
+	/** Serial number of the first sample recorded for the pawn in each slot: older samples belong to a previous occupant. */
+	TArray<uint32, TFixedAllocator<MaxTrackedPawns>> FirstSampleSerials;
+
+	/** Server time of each sample in the ring. */
+	TArray<float, TFixedAllocator<HistoryLength>> SampleTimes;
+
+	/** Monotonically increasing serial number of each sample in the ring. */
+	TArray<uint32, TFixedAllocator<HistoryLength>> SampleSerials;
+
+	/** Pawn locations, indexed by [SampleIndex * MaxTrackedPawns + Slot]. */
+	TArray<FVector> SampleLocations;
+
+	/** Index of the most recent sample in the ring. */
+	int32 HeadSample = INDEX_NONE;
+
+	/** Number of valid samples in the ring. */
+	int32 NumSamples = 0;
+
+	/** Serial number that will be assigned to the next recorded sample. */
+	uint32 NextSampleSerial = 0;
+
+	/** Number of occupied slots, lets us skip recording altogether when nobody is tracked. */
+	int32 NumTrackedPawns = 0;
+
+	int32 FindSlot(const AHoloPawn* Pawn) const;
+
+	/**
+	 * Finds the two samples surrounding the given time.
+	 * @returns false if there is no history to rewind into
+	 */
+	bool FindSamplesAtTime(float Time, int32& OutOlderSample, int32& OutNewerSample, float& OutAlpha) const;
+
+	/** Returns where the pawn in the given slot was, interpolated between two samples. */
+	bool GetRewoundLocation(int32 Slot, int32 OlderSample, int32 NewerSample, float Alpha, FVector& OutLocation) const;
+};
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "HoloLoadTestRecorderSubsystem.generated.h"
+
+class UNetDriver;
+struct FFrame;
+struct FOutParmRec;
+
+/**
+ * Records server performance during load tests (see UHoloLoadTestCommandlet) into a CSV file:
+ * frame time, bandwidth and packet rates per client connection, and the rate of RPCs sent, one row per sample interval.
+ * Traffic is sampled from the net driver and its connections, so engine RPCs and replication (e.g. character movement)
+ * are accounted for along with the game's own.
+ * Only created when the game is started with -HoloLoadTestCsv=<Path>.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloLoadTestRecorderSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** Seconds between two rows of the CSV file. */
+	UPROPERTY(Config)
+	float SampleInterval = 1.0f;
+
+private:
+
+	TUniquePtr<FArchive> CsvWriter;
+
+	/** Frame statistics accumulated since the last row. */
+	float TimeSinceLastSample = 0.0f;
+	int32 NumFrames = 0;
+	double TotalFrameTime = 0.0;
+	double TotalBusyTime = 0.0;
+	double MaxFrameTime = 0.0;
+
+	/** RPCs sent by the server since the last row, multicasts counted once per client connection. */
+	int32 NumSentRPCs = 0;
+
+	/** Net driver whose RPCs we're counting, see UNetDriver::SendRPCDel. */
+	TWeakObjectPtr<UNetDriver> HookedNetDriver;
+
+	/** Starts counting the RPCs of the world's net driver, once it exists. */
+	void HookNetDriver();
+	void UnhookNetDriver();
+	void OnSendRPC(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRPC);
+
+	void WriteLine(const FString& Line);
+	void WriteSample();
+};
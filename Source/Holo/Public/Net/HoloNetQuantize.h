@@ -0,0 +1,33 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact encodings used by the custom NetSerialize of the fire and hit payloads.
+ */
+namespace HoloNet
+{
+	/**
+	 * Times are sent as 16 bits of milliseconds, so they wrap around every PackedTimePeriod seconds.
+	 * The receiver recovers the full time with UnwrapPackedTime, against its own view of the server clock.
+	 */
+	static constexpr float PackedTimePeriod = 65.536f;
+
+	/** Serializes a server time as 16 bits. When loading, the time is only known modulo PackedTimePeriod. */
+	HOLO_API void SerializePackedTime(FArchive& Ar, float& Time);
+
+	/** Returns the time closest to ReferenceTime that matches PackedTime modulo PackedTimePeriod. */
+	HOLO_API float UnwrapPackedTime(float PackedTime, float ReferenceTime);
+
+	/** Maps a unit vector onto the octahedron unfolded into a square, with BitsPerComponent bits per axis of the square. */
+	HOLO_API uint32 EncodeOctahedral(const FVector& Normal, int32 BitsPerComponent);
+	HOLO_API FVector DecodeOctahedral(uint32 Packed, int32 BitsPerComponent);
+
+	/** Serializes a unit vector using 2 * BitsPerComponent bits. */
+	HOLO_API void SerializeOctahedralNormal(FArchive& Ar, FVector& Normal, int32 BitsPerComponent);
+
+	/** Serializes an offset with BitsPerComponent bits per component, clamping it to [-MaxOffset, MaxOffset] on every axis. */
+	HOLO_API void SerializeQuantizedOffset(FArchive& Ar, FVector& Offset, float MaxOffset, int32 BitsPerComponent);
+}
@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "HoloReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+/** How actors of a given class are routed to the nodes of the graph. */
+enum class EHoloClassRepNodeMapping : uint32
+{
+	NotRouted,					// Doesn't map to any node: replicated through the per-connection node, or as a dependent of another actor
+	RelevantAllConnections,		// Routes to the always relevant node
+	RelevantToOwner,			// Only replicated to the connection owning the actor, see UHoloReplicationGraphNode_OwnerRelevant_ForConnection
+
+	// Spatialized routes: actors are culled by their distance to the viewer, vertical included
+	Spatialize_Static,			// Never moves
+	Spatialize_Dynamic,			// Moves frequently, updated every frame
+	Spatialize_Dormancy,		// Moves when awake, treated as static while dormant
+};
+
+/**
+ * Per-connection node replicating the bOnlyRelevantToOwner actors owned by the connection.
+ * Owners are checked on every gather rather than when actors are added, as they change with possession.
+ */
+UCLASS()
+class HOLO_API UHoloReplicationGraphNode_OwnerRelevant_ForConnection : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin UReplicationGraphNode Interface
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	//~ End UReplicationGraphNode Interface
+
+private:
+
+	FActorRepListRefView ReplicationActorList;
+};
+
+/**
+ * Replication graph used by Holo game servers.
+ *
+ * Pawns and other moving actors live in a spatial grid, so each connection only considers the cells around its viewer
+ * instead of every actor of the world. Weapons aren't routed at all: they are dependent actors of their owning pawn,
+ * replicated right after it to the connections it's relevant to. Game and player states are relevant to everyone, and
+ * actors only relevant to their owner are gathered by the node of the owning connection.
+ *
+ * Enabled by the Holo.UseReplicationGraph console variable, the legacy net driver relevancy loop is used otherwise.
+ */
+UCLASS(Transient, Config=Engine)
+class HOLO_API UHoloReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin UReplicationGraph Interface
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	//~ End UReplicationGraph Interface
+
+	/**
+	 * Applies a change of the actor's NetUpdateFrequency to the graph, which otherwise only reads it once per class.
+	 * Does nothing if the actor's net driver doesn't use this graph.
+	 */
+	static void NotifyNetUpdateFrequencyChanged(AActor* Actor);
+
+	/** Every routed actor only relevant to its owner, whoever it currently is. */
+	const TArray<AActor*>& GetOwnerRelevantActors() const { return OwnerRelevantActors; }
+
+protected:
+
+	/** Size of the cells of the spatial grid. */
+	UPROPERTY(Config)
+	float GridCellSize = 10000.0f;
+
+	/** Lowest coordinates covered by the grid without having to rebuild it. */
+	UPROPERTY(Config)
+	float SpatialBiasX = -150000.0f;
+
+	UPROPERTY(Config)
+	float SpatialBiasY = -200000.0f;
+
+	/** Actors destroyed further than this from a connection's viewer aren't sent to it. */
+	UPROPERTY(Config)
+	float DestructionInfoMaxDistance = 30000.0f;
+
+	UPROPERTY(Transient)
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY(Transient)
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	UPROPERTY(Transient)
+	TArray<AActor*> OwnerRelevantActors;
+
+private:
+
+	/** Routing policy of each replicated class. */
+	TClassMap<EHoloClassRepNodeMapping> ClassRepNodePolicies;
+
+	EHoloClassRepNodeMapping GetMappingPolicy(const UClass* Class);
+
+	/** Works out the routing of a class from its default object. */
+	static EHoloClassRepNodeMapping GetDefaultMappingPolicy(const UClass* Class);
+
+	/** Fills the replication settings of a class from its default object: cull distance and update period. */
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, const UClass* Class, bool bSpatialize) const;
+
+	/** Number of server frames between two replications of an actor updating NetUpdateFrequency times per second. */
+	uint32 GetReplicationPeriodFrame(float NetUpdateFrequency) const;
+};
@@ -0,0 +1,73 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "HoloDamageQueueSubsystem.generated.h"
+
+class AHoloPawn;
+
+/**
+ * Server-side queue of the damage dealt to pawns during a frame.
+ * Hits only record their damage when they happen. Once per frame, after every actor ticked, the damage of each pawn is
+ * summed and applied in a single pass: one health write and broadcast, one damage feedback RPC, and at most one death.
+ * The killing blow is the event that brought the pawn's health to zero, in the order events were queued, i.e. the order
+ * in which the server processed the hits, so deaths resolve the same way however many hits land in a frame.
+ * Damage queued by subsystems ticking after this one is applied the next frame.
+ */
+UCLASS()
+class HOLO_API UHoloDamageQueueSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** [Server] Records damage dealt to the pawn, applied with the rest of the frame's damage by Auth_FlushDamage. */
+	void Auth_QueueDamage(AHoloPawn* Target, float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser);
+
+	/** [Server] Applies all the damage queued so far. Called every frame, exposed for code that needs the damage resolved right away. */
+	void Auth_FlushDamage();
+
+	int32 GetNumQueuedDamageEvents() const { return QueuedDamage.Num(); }
+
+private:
+
+	/** A damage event, with the polymorphic FDamageEvent flattened to the hit and direction it resolves to. */
+	struct FQueuedDamage
+	{
+		TWeakObjectPtr<AHoloPawn> Target;
+		TWeakObjectPtr<AController> EventInstigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TSubclassOf<UDamageType> DamageTypeClass;
+		FHitResult HitInfo;
+		FVector ShotDirection;
+		float Damage;
+	};
+
+	/** Damage of the frame accumulated for a pawn. */
+	struct FTargetDamage
+	{
+		AHoloPawn* Target;
+		float TotalDamage;
+
+		/** Index in QueuedDamage of the event that brings health to zero, or of the last event if none does. */
+		int32 DecisiveEvent;
+		bool bIsLethal;
+	};
+
+	TArray<FQueuedDamage> QueuedDamage;
+
+	/** Scratch storage of Auth_FlushDamage, kept to avoid reallocating it every frame. */
+	TArray<FTargetDamage> TargetDamage;
+	TMap<AHoloPawn*, int32> TargetIndices;
+};
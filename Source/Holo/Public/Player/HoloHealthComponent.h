@@ -36,6 +36,9 @@ public:
 	UFUNCTION(BlueprintCallable)
 	float ApplyDamage(float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser);
 
+	/** Restore full health, e.g. when the owner is reused after death. Server/authority only. */
+	void Auth_ResetHealth();
+
 private:
 	UFUNCTION()
 	void OnRep_CurrentHealth();
@@ -4,13 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Weapons/HoloProjectileSubsystem.h"
 #include "HoloPawn.generated.h"
 
+class AHoloWeapon;
 class UHoloGameLayoutWidget;
 class UHoloHealthComponent;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnPawnDying);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPawnColorChanged, const FLinearColor&, Color);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnPawnWeaponChanged, AHoloWeapon* /*Weapon*/);
+DECLARE_MULTICAST_DELEGATE(FOnPawnRespawned);
 
 UCLASS()
 class HOLO_API AHoloPawn : public ACharacter
@@ -24,11 +28,15 @@ public:
 	//~ Begin AActor Interface
 	virtual void Tick(float DeltaTime) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void PostInitializeComponents() override;
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
 	//~ End AActor Interface
 
 	//~ Begin APawn Interface
 	virtual float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void PawnClientRestart() override;
 	//~ End APawn Interface
 
 	//~ Begin ACharacter Interface
@@ -39,6 +47,14 @@ public:
 	void Auth_SetColor(const FLinearColor& InColor);
 	FLinearColor& GetColor() { return Color; };
 	UHoloHealthComponent* GetHealthComponent() const;
+	AHoloWeapon* GetWeapon() const { return Weapon; }
+	const TSoftClassPtr<AHoloWeapon>& GetDefaultWeaponClass() const { return DefaultWeaponClass; }
+
+	/**
+	 * Adds the classes the pawn spawns, which are soft references, to the list of assets to load.
+	 * @param bCosmetics - Whether to include the content only used by local players, e.g. widgets
+	 */
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets, bool bCosmetics) const;
 
 	/**
 	* Kills pawn.  Server/authority only.
@@ -53,13 +69,26 @@ public:
 	/** Returns True if the pawn can die in the current state */
 	virtual bool CanDie(float KillingDamage, FDamageEvent const& DamageEvent, AController* Killer, AActor* DamageCauser) const;
 
-	/** Delegate fire when the Pawn dies */
+	/**
+	 * Applies the damage taken during the frame, gathered by UHoloDamageQueueSubsystem. Server/authority only.
+	 * @param TotalDamage - Sum of the damage of the frame
+	 * @param DamageEvent - Damage event of the killing blow if the damage is lethal, of the last hit otherwise
+	 */
+	void Auth_ApplyQueuedDamage(float TotalDamage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser);
+
+	/** Delegate fire when the Pawn dies, on the server and clients */
 	UPROPERTY(BlueprintAssignable)
 	FOnPawnDying OnDyingDelegate;
+
+	/** Broadcast on the server and clients when the dead pawn is brought back to life through the pool. */
+	FOnPawnRespawned OnRespawnedDelegate;
 	
 	UPROPERTY(BlueprintAssignable)
 	FOnPawnColorChanged OnColorChangedDelegate;
 
+	/** Broadcast when the weapon is attached to the pawn, which may happen after the pawn is possessed on clients. */
+	FOnPawnWeaponChanged OnWeaponChangedDelegate;
+
 	/** Identifies if pawn is in its dying state */
 	UPROPERTY(ReplicatedUsing = OnRep_IsDying, BlueprintReadOnly, Category = Health)
 	uint32 bIsDying : 1;
@@ -67,9 +96,28 @@ public:
 	UFUNCTION()
 	void OnRep_IsDying();
 
-	/** Destroy and restart player */
+	/** Ask the controller to respawn: this pawn and its weapon are reused, see AHoloGameMode::RestartPlayerAtPlayerStart */
 	void RestartPlayer();
 
+	/** Brings a dead or pooled pawn back to life at the given location, ready to be possessed again. Server/authority only. */
+	void Auth_ResetForRespawn(const FVector& Location, const FRotator& Rotation);
+
+	/** Hides the pawn and its weapon and stops all of their processing, while they're waiting in the pawn pool. Server/authority only. */
+	void Auth_Deactivate();
+
+	/** Replicates this pawn and its weapon at the combat rate for a while: called when it fires or takes damage. Server/authority only. */
+	void Auth_NotifyCombatActivity();
+
+	/** Returns the time elapsed since the last call to Auth_NotifyCombatActivity. */
+	float GetTimeSinceCombatActivity() const;
+
+	/** Feeds input generated by a bot (see AHoloPlayerController) through the same handlers as player input. */
+	void ApplyBotInput(float MoveForward, float MoveRight, float MoveUp, bool bFire);
+
+	/** Replicates a projectile fired by our weapon to the other clients, which simulate it on their own. The shooter already predicted it. */
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_SpawnProjectile(const FHoloProjectileSpawn& Spawn);
+
 protected:
 
 	/** Scene component indicating where the pawn's Weapon should be attached. */
@@ -83,15 +131,20 @@ protected:
 	UPROPERTY(ReplicatedUsing=OnRep_Weapon, Transient, BlueprintReadOnly, Category="Weapon")
 	class AHoloWeapon* Weapon;
 
-	/** The weapon class that will be created on spawn */
+	/** The weapon class that will be created on spawn. Preloaded with the map by UHoloAssetPreloadSubsystem. */
 	UPROPERTY(EditDefaultsOnly, Category="Weapon")
-	TSubclassOf<AHoloWeapon> DefaultWeaponClass;
+	TSoftClassPtr<AHoloWeapon> DefaultWeaponClass;
 
+	/** Preloaded with the map by UHoloAssetPreloadSubsystem on machines with local players. */
 	UPROPERTY(EditDefaultsOnly, Category="Widgets")
-	TSubclassOf<UHoloGameLayoutWidget> GameLayoutWidgetClass;
+	TSoftClassPtr<UHoloGameLayoutWidget> GameLayoutWidgetClass;
 	
 	UPROPERTY(EditDefaultsOnly, Category=Effects)
 	TSubclassOf<UCameraShakeBase> DamageCameraShake;
+
+	/** Damage taken in a frame that plays DamageCameraShake at full scale, less damage shakes less. */
+	UPROPERTY(EditDefaultsOnly, Category=Effects)
+	float DamageCameraShakeFullScaleDamage;
 	
 	UPROPERTY(EditDefaultsOnly, Category=Effects)
 	TSubclassOf<UCameraShakeBase> DeathCameraShake;
@@ -99,10 +152,49 @@ protected:
 	UPROPERTY(BlueprintReadOnly, Category="Widgets")
 	UHoloGameLayoutWidget* GameLayoutWidget;
 
+	/** Network update rate of pawns that haven't fired or been damaged for a while. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float IdleNetUpdateFrequency;
+
+	/** Network update rate of pawns that are firing or being damaged. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float CombatNetUpdateFrequency;
+
+	/** How long the combat rate is kept after the last combat activity, before it starts decaying. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float CombatActivityHoldTime;
+
+	/** How long it takes to go from the combat rate back down to the idle rate. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float CombatActivityDecayTime;
+
+	/** Pawns closer than this to a connection's viewer get their priority scaled by NearPriorityScale for that connection. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float NearPriorityDistance;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float NearPriorityScale;
+
+	/** Pawns within this angle of where a connection's viewer is aiming get their priority scaled by AimConePriorityScale for that connection. */
+	UPROPERTY(EditDefaultsOnly, Category="Replication", meta=(ClampMin="0.0", ClampMax="90.0", Units="Degrees"))
+	float AimConeHalfAngle;
+
+	UPROPERTY(EditDefaultsOnly, Category="Replication")
+	float AimConePriorityScale;
+
+	/** Server time of the last shot fired or damage taken. */
+	float LastCombatActivityTime;
+
 	/** Material instance assigned to the character mesh, giving us control over the shader parameters at runtime. */
 	UPROPERTY(BlueprintReadOnly, Category="Player")
 	UMaterialInstanceDynamic* MeshMID;
 	
+	/** Collision profile of the mesh, restored when leaving ragdoll. */
+	FName MeshCollisionProfileName;
+
+	/** Handle of the timer restarting the player after death. */
+	FTimerHandle TimerHandle_Restart;
+
 	/** An arbitrary color that identifies this player; assigned by the game mode on spawn. Controls the color of the mesh. */
 	UPROPERTY(ReplicatedUsing=OnRep_Color, Transient, BlueprintReadOnly, Category="Player")
 	FLinearColor Color;
@@ -116,10 +208,20 @@ protected:
 	/** switch to ragdoll */
 	void SetRagdollPhysics();
 
-	void PlayCameraShake(TSubclassOf<UCameraShakeBase> CameraShake) const;
+	/** Undo everything OnRep_IsDying did, for both the server and client. */
+	void ResetDeathState();
+
+	/** Creates the game layout widget if this pawn is locally controlled and doesn't have one yet. */
+	void CreateGameLayoutWidget();
+
+	/** Moves the network update rate of this pawn and its weapon from the combat rate toward the idle rate. Server/authority only. */
+	void Auth_UpdateNetUpdateFrequency();
 
+	void PlayCameraShake(TSubclassOf<UCameraShakeBase> CameraShake, float Scale = 1.0f) const;
+
+	/** Plays the feedback of the damage taken during a frame. */
 	UFUNCTION(client, unreliable)
-	void Client_SimulateDamage();
+	void Client_SimulateDamage(float Damage);
 
 private:
 
@@ -137,6 +239,9 @@ private:
 
 	UFUNCTION()
 	void OnFire();
+
+	UFUNCTION()
+	void OnStopFire();
 	
 	UFUNCTION()
 	void OnMoveForward(float AxisValue);
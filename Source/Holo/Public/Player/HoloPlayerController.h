@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Weapons/HoloFireCommand.h"
 #include "HoloPlayerController.generated.h"
 
 /**
@@ -15,6 +16,57 @@ class HOLO_API AHoloPlayerController : public APlayerController
 
 public:
 
+	AHoloPlayerController();
+
+	//~ Begin AActor Interface
+	virtual void BeginPlay() override;
+	//~ End AActor Interface
+
+	//~ Begin APlayerController Interface
+	virtual void PlayerTick(float DeltaTime) override;
+	virtual void PawnLeavingGame() override;
+	//~ End APlayerController Interface
+
 	/** respawn after dying */
 	void Respawn();
+
+	/**
+	 * Fire commands stream of the weapon of our pawn: unreliable, so a lost packet never stalls the reliable channel.
+	 * Goes through the controller since the weapon is dormant between shots, and dormant actors can't receive RPCs from clients.
+	 */
+	UFUNCTION(Server, Unreliable)
+	void Server_SendFireCommands(const FHoloFireCommandPacket& Packet);
+
+	/** Tells the owning client the most recent fire command the server has processed, and which of its latest shots caused damage. */
+	UFUNCTION(Client, Unreliable)
+	void Client_AckFireCommands(const FHoloFireAck& Ack);
+
+protected:
+
+	/** Bots engage the closest enemy within this distance. */
+	UPROPERTY(EditDefaultsOnly, Category="Bot")
+	float BotEngageDistance;
+
+	/** Bots fire when their target is within this angle of their view. */
+	UPROPERTY(EditDefaultsOnly, Category="Bot", meta=(Units="Degrees"))
+	float BotFireConeHalfAngle;
+
+	/** How quickly bots turn toward what they're looking at. */
+	UPROPERTY(EditDefaultsOnly, Category="Bot")
+	float BotAimInterpSpeed;
+
+private:
+
+	/** Set on local controllers when the game was started with -HoloBot: the controller then flies and fights on its own, for load tests. */
+	bool bIsBot;
+
+	/** [Bot] Location the bot is currently flying toward, and when it will pick a new one. */
+	FVector BotWanderLocation;
+	float BotNextWanderTime;
+
+	/** [Bot] Generates this frame's input for our pawn. */
+	void UpdateBot(float DeltaTime);
+
+	/** Returns the weapon of our pawn, if any. */
+	class AHoloWeapon* GetPawnWeapon() const;
 };
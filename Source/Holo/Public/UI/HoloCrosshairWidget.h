@@ -0,0 +1,95 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Weapons/HoloFireCommand.h"
+#include "HoloCrosshairWidget.generated.h"
+
+class AHoloWeapon;
+
+/**
+ * Crosshair and hit marker, painted at the center of the widget.
+ * The widget doesn't tick: it's only repainted when the pawn's color changes, when it dies or respawns, or while the
+ * crosshair expansion after a shot and the hit marker fade out, at no more than AnimationRepaintRate per second. With
+ * global invalidation, the rest of the time it's drawn from Slate's cache.
+ */
+UCLASS(meta=(DisableNativeTick))
+class HOLO_API UHoloCrosshairWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin UUserWidget Interface
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+	virtual int32 NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	//~ End UUserWidget Interface
+
+protected:
+
+	/** Length of the crosshair, at rest and fully expanded. */
+	UPROPERTY(EditDefaultsOnly, Category="Crosshair")
+	FVector2D CrosshairSize = FVector2D(16.0f, 22.0f);
+
+	/** Gap at the center of the crosshair, at rest and fully expanded. */
+	UPROPERTY(EditDefaultsOnly, Category="Crosshair")
+	FVector2D CrosshairGapSize = FVector2D(6.0f, 20.0f);
+
+	/** How long the crosshair takes to go back to rest after a shot expanded it. */
+	UPROPERTY(EditDefaultsOnly, Category="Crosshair")
+	float CrosshairRecoveryTime = 0.25f;
+
+	/** How long the hit marker stays on screen after a hit, fading out. */
+	UPROPERTY(EditDefaultsOnly, Category="HitMarker")
+	float HitMarkerDuration = 0.3f;
+
+	/** Color of the hit marker while the server hasn't confirmed the hit yet. */
+	UPROPERTY(EditDefaultsOnly, Category="HitMarker")
+	FLinearColor PredictedHitMarkerColor = FLinearColor::White;
+
+	/** Color of the hit marker once the server confirmed the hit. */
+	UPROPERTY(EditDefaultsOnly, Category="HitMarker")
+	FLinearColor ConfirmedHitMarkerColor = FLinearColor::Red;
+
+	/** Repaints per second while animating. */
+	UPROPERTY(EditDefaultsOnly, Category="Performance")
+	float AnimationRepaintRate = 30.0f;
+
+private:
+
+	TWeakObjectPtr<AHoloWeapon> Weapon;
+
+	FLinearColor Color = FLinearColor::White;
+
+	/** Game time of the last shot we fired, which expanded the crosshair. */
+	float LastShotTime = TNumericLimits<float>::Lowest();
+
+	FDelegateHandle WeaponChangedHandle;
+	FDelegateHandle RespawnedHandle;
+	FDelegateHandle ShotFiredHandle;
+	FDelegateHandle HitFeedbackHandle;
+	FDelegateHandle RepaintTickerHandle;
+
+	UFUNCTION()
+	void ColorChanged(const FLinearColor& NewColor);
+
+	/** The crosshair is hidden while the pawn is dead. */
+	UFUNCTION()
+	void PawnDying();
+
+	void PawnRespawned();
+	void WeaponChanged(AHoloWeapon* NewWeapon);
+	void ShotFired();
+	void HitFeedback(uint16 ShotSequence, EHoloHitFeedback Feedback);
+
+	/** Repaints the widget, and keeps repainting it at AnimationRepaintRate until its animations are over. */
+	void StartAnimating();
+	bool AnimationTick(float DeltaTime);
+	bool IsAnimating() const;
+
+	/** Value between 0 and 1 indicating how much the crosshair is expanded. */
+	float GetCrosshairExpandWeight() const;
+};
@@ -6,13 +6,42 @@
 #include "Blueprint/UserWidget.h"
 #include "HoloGameLayoutWidget.generated.h"
 
+struct FAnchors;
+
+/**
+ * Everything the player sees on top of the game. Its widgets are event driven and retained: they're only repainted when
+ * what they show changes, see Slate.EnableGlobalInvalidation and "stat Holo". Each of them is wrapped in an invalidation
+ * box, so that one repainting (e.g. the crosshair while it animates) doesn't repaint the others.
+ */
 UCLASS(BlueprintType, Blueprintable)
 class HOLO_API UHoloGameLayoutWidget : public UUserWidget
 {
 	GENERATED_BODY()
 
+public:
+
+	//~ Begin UUserWidget Interface
+	virtual void NativeOnInitialized() override;
+	//~ End UUserWidget Interface
+
 protected:
 
 	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
 	class UHoloPlayerHealthWidget* PlayerHealthWidget;
+
+	/** Created and stretched over the whole layout if the layout doesn't place one. */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	class UHoloCrosshairWidget* CrosshairWidget;
+
+	/** Created in the top right corner of the layout if the layout doesn't place one. */
+	UPROPERTY(BlueprintReadWrite, meta = (BindWidgetOptional))
+	class UHoloKillFeedWidget* KillFeedWidget;
+
+private:
+
+	/** Adds a widget of the given class to the root panel of the layout, placed according to the anchors if it's a canvas. */
+	UUserWidget* AddDefaultWidget(TSubclassOf<UUserWidget> WidgetClass, const FAnchors& Anchors, const FMargin& Offsets);
+
+	/** Puts an invalidation box between the widget and its parent, in the widget's slot. */
+	void WrapInInvalidationBox(UWidget* Widget);
 };
@@ -7,22 +7,11 @@
 #include "HoloHUD.generated.h"
 
 /**
- * 
+ * Draws nothing by itself: the crosshair, hit markers, health and kill feed are retained UMG widgets of
+ * UHoloGameLayoutWidget, which only repaint when they change instead of issuing canvas draw calls every frame.
  */
 UCLASS()
 class HOLO_API AHoloHUD : public AHUD
 {
 	GENERATED_BODY()
-
-public:
-	//~ Begin AHUD Interface
-	virtual void DrawHUD() override;
-	//~ End AHUD Interface
-
-private:
-
-	/** Value between 0 and 1 indicating whether the crosshair is expanded */
-	float CrosshairExpandWeight = 0.0f;
-
-	void DrawCrosshair(const FLinearColor& Color, float TotalSize, float GapSize);
 };
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "HoloKillFeedWidget.generated.h"
+
+class APlayerState;
+
+/**
+ * List of the latest kills, newest at the top, painted from the top left corner of the widget.
+ * The widget doesn't tick: it's only repainted when a kill is announced by AHoloGameState, or when an entry expires.
+ */
+UCLASS(meta=(DisableNativeTick))
+class HOLO_API UHoloKillFeedWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	UHoloKillFeedWidget(const FObjectInitializer& ObjectInitializer);
+
+	//~ Begin UUserWidget Interface
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+	virtual int32 NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	//~ End UUserWidget Interface
+
+protected:
+
+	/** Kills listed at most, older ones are dropped. */
+	UPROPERTY(EditDefaultsOnly, Category="KillFeed")
+	int32 MaxEntries = 5;
+
+	/** How long each kill stays listed. */
+	UPROPERTY(EditDefaultsOnly, Category="KillFeed")
+	float EntryDuration = 5.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category="KillFeed")
+	FSlateFontInfo Font;
+
+	UPROPERTY(EditDefaultsOnly, Category="KillFeed")
+	FLinearColor TextColor = FLinearColor::White;
+
+	/** Height of each line of the list. */
+	UPROPERTY(EditDefaultsOnly, Category="KillFeed")
+	float LineHeight = 22.0f;
+
+private:
+
+	struct FKillFeedEntry
+	{
+		FText Text;
+		float ExpireTime;
+	};
+
+	/** Listed kills, oldest first. */
+	TArray<FKillFeedEntry> Entries;
+
+	FDelegateHandle KillHandle;
+	FTimerHandle ExpireTimerHandle;
+
+	void KillNotified(APlayerState* Killer, APlayerState* Victim);
+
+	/** Removes the expired entries and schedules the next expiration. */
+	void ExpireEntries();
+};
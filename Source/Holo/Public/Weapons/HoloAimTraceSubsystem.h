@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "WorldCollision.h"
+#include "HoloAimTraceSubsystem.generated.h"
+
+class AHoloWeapon;
+
+/**
+ * Gathers the aim traces of all locally controlled weapons during the frame and issues them as a single batch of async traces.
+ * Results are handed back to the weapons on the next frame.
+ */
+UCLASS()
+class HOLO_API UHoloAimTraceSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Queues an aim trace for the weapon: the result will be passed to AHoloWeapon::ApplyAimLocation next frame. */
+	void RequestAimTrace(AHoloWeapon* Weapon, const FVector& TraceStart, const FVector& TraceEnd, const FTransform& ViewTransform);
+
+private:
+
+	struct FAimTraceRequest
+	{
+		TWeakObjectPtr<AHoloWeapon> Weapon;
+		FVector TraceStart;
+		FVector TraceEnd;
+		FTransform ViewTransform;
+	};
+
+	/** Requests gathered during the current frame. */
+	TArray<FAimTraceRequest> PendingRequests;
+
+	/** Requests waiting for their results, double buffered since results come back the frame after they were issued. */
+	TArray<FAimTraceRequest> InFlightRequests[2];
+
+	/** Index of the InFlightRequests buffer used by the most recent batch. */
+	uint32 CurrentBuffer = 0;
+
+	FTraceDelegate TraceDelegate;
+
+	void OnAimTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+};
@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "HoloAreaDamageSubsystem.generated.h"
+
+class AHoloPawn;
+
+/**
+ * Server-side resolution of area of effect damage, e.g. exploding projectiles, batched for all the explosions of a frame.
+ * Living pawns are kept in a uniform spatial hash, updated incrementally as they move between cells, so finding the pawns
+ * caught in an explosion only visits the cells overlapping its radius instead of running an overlap query per explosion.
+ * Pawns within range of the explosions are checked for occlusion by level geometry with a batch of async traces; once
+ * their results are in, next frame, each exposed pawn takes radial damage with the usual falloff.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloAreaDamageSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/** Starts tracking the pawn in the spatial hash. */
+	void RegisterPawn(AHoloPawn* Pawn);
+
+	/** Stops tracking the pawn, e.g. when it's pooled or destroyed. */
+	void UnregisterPawn(AHoloPawn* Pawn);
+
+	/** [Server] Queues an explosion, resolved along with every other explosion of the frame. */
+	void Auth_QueueExplosion(const FVector& Origin, const FRadialDamageParams& Params, AController* EventInstigator, AActor* DamageCauser);
+
+	/**
+	 * [Server] Deals the damage of the explosions whose occlusion traces completed, then finds the pawns caught in the queued
+	 * explosions and issues their occlusion traces. Called every frame, exposed for benchmarks.
+	 * @param bBlockingTraces - Runs the occlusion traces on the game thread and deals their damage right away, rather than
+	 *                          next frame: lets benchmarks measure the whole cost of a batch at once
+	 */
+	void Auth_ProcessExplosions(bool bBlockingTraces = false);
+
+protected:
+
+	/** Size of the cells of the spatial hash. Explosions visit every cell overlapping their outer radius. */
+	UPROPERTY(Config)
+	float CellSize = 1000.0f;
+
+private:
+
+	struct FExplosion
+	{
+		FVector Origin;
+		FRadialDamageParams Params;
+		TWeakObjectPtr<AController> EventInstigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	/** A pawn within range of an explosion, damaged unless its occlusion trace is blocked. */
+	struct FExplosionTarget
+	{
+		TWeakObjectPtr<AHoloPawn> Pawn;
+		int32 Explosion;
+
+		/** Point of the pawn closest to the explosion, which drives the falloff. */
+		FVector ClosestPoint;
+		bool bOccluded;
+	};
+
+	/** Registered pawns; PawnCells is indexed the same way. */
+	UPROPERTY(Transient)
+	TArray<AHoloPawn*> Pawns;
+
+	/** Cell each pawn was bucketed in, as of the last update of the spatial hash. */
+	TArray<FIntVector> PawnCells;
+
+	/** Indices of the pawns of each cell of the spatial hash. */
+	TMap<FIntVector, TArray<int32>> Grid;
+
+	TArray<FExplosion> QueuedExplosions;
+
+	/** Explosions whose occlusion traces are in flight, along with the pawns they may damage. */
+	TArray<FExplosion> InFlightExplosions;
+	TArray<FExplosionTarget> InFlightTargets;
+	int32 NumCompletedTraces = 0;
+
+	FTraceDelegate TraceDelegate;
+
+	/** Moves the pawns that changed cell since the last update. */
+	void UpdateGrid();
+	void ApplyInFlightExplosions();
+	void IssueOcclusionTraces(bool bBlockingTraces);
+	void OnOcclusionTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	FIntVector GetCell(const FVector& Location) const;
+};
@@ -0,0 +1,106 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "HoloFireCommand.generated.h"
+
+/** A single shot requested by a client. */
+USTRUCT()
+struct FHoloFireCommand
+{
+	GENERATED_BODY()
+
+	/** Muzzle offsets are sent with MuzzleOffsetBits per axis, within [-MaxMuzzleOffset, MaxMuzzleOffset]. */
+	static constexpr float MaxMuzzleOffset = 256.0f;
+	static constexpr int32 MuzzleOffsetBits = 10;
+
+	/** Directions are sent octahedral-encoded with DirectionBits per axis of the octahedron. */
+	static constexpr int32 DirectionBits = 12;
+
+	/** Sequence number of the command: increases by one for every shot, wrapping around. Also the key of the client's prediction of the shot. */
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	/**
+	 * Server world time as seen by the client when it fired.
+	 * Only known modulo HoloNet::PackedTimePeriod after being received, see HoloNet::UnwrapPackedTime.
+	 */
+	UPROPERTY()
+	float ClientFireTime = 0.0f;
+
+	/** Location of the muzzle on the client when it fired, relative to the location of the shooter's pawn. */
+	UPROPERTY()
+	FVector MuzzleOffset = FVector::ZeroVector;
+
+	/** Direction the weapon was pointing on the client when it fired. */
+	UPROPERTY()
+	FVector Direction = FVector::ForwardVector;
+
+	/** Returns true if sequence A was issued after sequence B, taking wrap around into account. */
+	static bool IsSequenceNewer(uint16 A, uint16 B)
+	{
+		return static_cast<int16>(A - B) > 0;
+	}
+
+	/** Serializes everything but the sequence number, which is implied by the packet. */
+	void SerializePayload(FArchive& Ar);
+};
+
+/**
+ * A batch of fire commands, sent unreliably.
+ * Every packet repeats the most recent commands the server hasn't acknowledged yet, so losing a packet doesn't lose shots.
+ * Commands in a packet always have consecutive sequence numbers: only the first one is sent.
+ */
+USTRUCT()
+struct FHoloFireCommandPacket
+{
+	GENERATED_BODY()
+
+	/** Maximum number of commands carried by a single packet. */
+	static constexpr int32 MaxCommands = 8;
+
+	/** Commands to process, oldest first. */
+	UPROPERTY()
+	TArray<FHoloFireCommand> Commands;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+/**
+ * Acknowledgement of the fire commands processed by the server, sent back to the shooter.
+ * Also carries the outcome of the most recent shots, so the client can confirm or roll back the hits it predicted.
+ */
+USTRUCT()
+struct FHoloFireAck
+{
+	GENERATED_BODY()
+
+	/** Number of shots whose outcome is carried by DamageMask. */
+	static constexpr int32 NumOutcomes = 16;
+
+	/** Sequence number of the most recent command processed. */
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	/** Bit N is set if the shot with sequence number (Sequence - N) caused damage. */
+	UPROPERTY()
+	uint16 DamageMask = 0;
+
+	/** Returns false if the shot missed, was rejected, never reached the server, or is too old to be known. */
+	bool CausedDamage(uint16 ShotSequence) const
+	{
+		const uint16 Age = Sequence - ShotSequence;
+		return Age < NumOutcomes && (DamageMask & (1u << Age)) != 0;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FHoloFireCommandPacket> : public TStructOpsTypeTraitsBase2<FHoloFireCommandPacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -0,0 +1,128 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "WorldCollision.h"
+#include "HoloProjectileSubsystem.generated.h"
+
+class AHoloWeapon;
+class UParticleSystemComponent;
+
+/** A projectile fired by a weapon: the only thing replicated about it, everything else is simulated from there. */
+USTRUCT()
+struct FHoloProjectileSpawn
+{
+	GENERATED_BODY()
+
+	/** Directions are sent octahedral-encoded with DirectionBits per axis of the octahedron. */
+	static constexpr int32 DirectionBits = 12;
+
+	UPROPERTY()
+	FVector_NetQuantize Origin = FVector::ZeroVector;
+
+	/** Direction the weapon was pointing, before spread. */
+	UPROPERTY()
+	FVector Direction = FVector::ForwardVector;
+
+	/** Seed of the spread of the projectile: the fire command sequence. */
+	UPROPERTY()
+	uint16 Seed = 0;
+
+	/** Server world time of the shot. Only known modulo HoloNet::PackedTimePeriod after being received. */
+	UPROPERTY()
+	float ServerSpawnTime = 0.0f;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHoloProjectileSpawn> : public TStructOpsTypeTraitsBase2<FHoloProjectileSpawn>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Simulates every projectile of the world, without an actor per projectile.
+ * Projectiles are stored in contiguous arrays and follow analytic ballistic trajectories from their spawn, so every machine
+ * computes the same positions whatever its frame rate: only spawns are replicated. Positions are advanced in a single
+ * vectorized loop per frame, and the swept segments are checked for hits with a batch of async sweeps, resolved next frame.
+ * Projectiles are authoritative (they deal damage) on the server only, and purely cosmetic on clients.
+ * Where cosmetics are played, each projectile drags its weapon's trail effect along its trajectory.
+ */
+UCLASS(Config=Game)
+class HOLO_API UHoloProjectileSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~ End USubsystem Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	/**
+	 * Launches a projectile of the weapon.
+	 * @param LocalSpawnTime - Game time of this world at which the projectile was fired, possibly in the past: it's fast-forwarded
+	 * @param bAuthoritative - Whether the projectile deals damage when it hits, rather than only playing effects
+	 */
+	void SpawnProjectile(AHoloWeapon* Weapon, const FHoloProjectileSpawn& Spawn, float LocalSpawnTime, bool bAuthoritative);
+
+	int32 GetNumProjectiles() const { return Weapons.Num(); }
+
+protected:
+
+	/** Projectiles beyond this count aren't spawned. */
+	UPROPERTY(Config)
+	int32 MaxProjectiles = 1024;
+
+	/** Projectiles fired longer ago than this are fast-forwarded by this much only. */
+	UPROPERTY(Config)
+	float MaxFastForwardTime = 0.5f;
+
+private:
+
+	/** Weapon that fired each projectile; every other array is indexed the same way. */
+	UPROPERTY(Transient)
+	TArray<AHoloWeapon*> Weapons;
+
+	TArray<FVector> Origins;
+	TArray<FVector> Velocities;
+	TArray<FVector> Accelerations;
+	TArray<float> SpawnTimes;
+	TArray<float> Lifetimes;
+	TArray<float> Radii;
+	TArray<bool> Authoritative;
+
+	/** Pooled trail effect following each projectile, null if there's none or it was restarted for another projectile. */
+	UPROPERTY(Transient)
+	TArray<UParticleSystemComponent*> Trails;
+
+	/** Start and end of the segment each projectile swept this frame, checked by the sweep in flight. */
+	TArray<FVector> SegmentStarts;
+	TArray<FVector> SegmentEnds;
+
+	/** Results of the sweeps in flight, gathered when they complete. */
+	TArray<bool> HasHit;
+	TArray<FHitResult> Hits;
+
+	/** Whether sweeps were issued last frame, whose results are awaited. */
+	bool bSweepsInFlight = false;
+
+	FTraceDelegate SweepDelegate;
+
+	void OnSweepCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+	void RemoveProjectile(int32 Index);
+
+	/** Moves the trails to their projectile's position and direction of travel. */
+	void UpdateTrails(float CurrentTime);
+};
@@ -3,15 +3,22 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
 #include "GameFramework/Actor.h"
+#include "Weapons/HoloFireCommand.h"
+#include "Weapons/HoloProjectileSubsystem.h"
 #include "HoloWeapon.generated.h"
 
+/** A fire event generated by the server, replicated to non-owning clients through FHoloHitEventLog. */
 USTRUCT(BlueprintType)
-struct FInstantHitInfo
+struct FInstantHitInfo : public FFastArraySerializerItem
 {
 	GENERATED_BODY()
 
-	/** Game time on the server when this fire event occurred. */
+	/** Impact normals are only used for effects: they're sent octahedral-encoded with ImpactNormalBits per axis. */
+	static constexpr int32 ImpactNormalBits = 8;
+
+	/** Game time on the server when this fire event occurred. Only known modulo HoloNet::PackedTimePeriod on clients. */
 	UPROPERTY()
 	float ServerFireTime;
 
@@ -26,6 +33,89 @@ struct FInstantHitInfo
 	/** World-space surface normal of the hit: if zero, no hit occurred. */
 	UPROPERTY()
 	FVector_NetQuantizeNormal ImpactNormal;
+
+	FInstantHitInfo()
+		: ServerFireTime(0.0f)
+		, bCausedDamage(false)
+		, ImpactPoint(FVector::ZeroVector)
+		, ImpactNormal(FVector::ZeroVector)
+	{
+	}
+
+	//~ Begin FFastArraySerializerItem Interface
+	void PostReplicatedAdd(const struct FHoloHitEventLog& InArraySerializer);
+	//~ End FFastArraySerializerItem Interface
+
+	/** Packs the time in 16 bits, the flags in 2, and only sends the impact for shots that hit something. */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInstantHitInfo> : public TStructOpsTypeTraitsBase2<FInstantHitInfo>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Bounded log of the most recent fire events of a weapon.
+ * Every event is delivered to clients exactly once, even if several shots happen within a single net update
+ * or a shot is identical to the previous one, and only new events are sent thanks to delta serialization.
+ */
+USTRUCT()
+struct FHoloHitEventLog : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Events, oldest first. */
+	UPROPERTY()
+	TArray<FInstantHitInfo> Items;
+
+	/** Weapon owning this log, notified when events are received. */
+	class AHoloWeapon* OwnerWeapon = nullptr;
+
+	/** Appends an event, dropping the oldest ones so that the log never holds more than MaxEvents. */
+	void AddEvent(const FInstantHitInfo& HitInfo, int32 MaxEvents);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInstantHitInfo, FHoloHitEventLog>(Items, DeltaParms, *this);
+	}
+};
+
+/** How the weapon fires while its trigger is held. */
+UENUM(BlueprintType)
+enum class EHoloFireMode : uint8
+{
+	/** One shot per trigger pull. */
+	SemiAuto,
+	/** Fires continuously while the trigger is held. */
+	FullAuto,
+	/** A fixed number of shots per trigger pull. */
+	Burst,
+};
+
+/** Local hit feedback of the shots of the local player. */
+UENUM()
+enum class EHoloHitFeedback : uint8
+{
+	/** The shot looks like it caused damage: shown right away, without waiting for the server. */
+	Predicted,
+	/** The server confirmed the shot caused damage, whether it was predicted or not. */
+	Confirmed,
+	/** The server disagreed with a predicted hit: its feedback must be taken back. */
+	RolledBack,
+};
+
+template<>
+struct TStructOpsTypeTraits<FHoloHitEventLog> : public TStructOpsTypeTraitsBase2<FHoloHitEventLog>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
 };
 
 UCLASS()
@@ -36,22 +126,99 @@ class HOLO_API AHoloWeapon : public AActor
 public:
 	AHoloWeapon();
 	virtual void BeginPlay() override;
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/**
+	 * Update aiming location, find the closest blocking geometry that's centered in front of our view.
+	 * Only locally controlled weapons trace (asynchronously, through UHoloAimTraceSubsystem): the others aim straight ahead.
+	 */
+	void UpdateAimLocation(const FVector& ViewLocation, const FTransform& ViewTransform);
+
+	/** Sets the world-space location the weapon is aiming at, and whether it's far enough in front of the view to be aimed at */
+	void ApplyAimLocation(const FVector& InAimLocation, const FTransform& ViewTransform);
 
-	/** Update aiming location, find the closest blocking geometry that's centered in front of our view */
-	void UpdateAimLocation(FVector& ViewLocation, FTransform& ViewTransform);
+	/** Freezes or resumes the rotation of the weapon toward what the player is aiming at (see UHoloWeaponRotationSubsystem) */
+	void SetRotationUpdatesEnabled(bool bEnabled);
 
-	/** Update the rotation of the weapon to show what the player is aiming at */
-	void AdjustWeaponRotation();
+	const FVector& GetAimLocation() const { return AimLocation; }
+	bool IsAimLocationValid() const { return bAimLocationIsValid; }
 
 	//////////////////////////////////////////////////////////////////////////
 	// Weapon usage
 	//////////////////////////////////////////////////////////////////////////
 
-	void HandleFireInput();
+	/** Pulls the trigger: fires a single shot, a burst, or continuously until StopFire, depending on FireMode. */
+	void StartFire();
+
+	/** Releases the trigger. Stops full automatic fire, bursts always complete. */
+	void StopFire();
+
+	/**
+	 * Fires the shots that are due by now. Called once per frame by the owning player controller, after input.
+	 * Shots are scheduled at exact multiples of FireCooldown and stamped with the time they were due rather than
+	 * the frame time, so the fire rate doesn't depend on the frame rate: a frame may fire several shots, all sent in one packet.
+	 */
+	void UpdateFiring();
+
+	/**
+	 * Gathers the fire commands issued this frame, along with the ones the server hasn't acknowledged yet.
+	 * Called once per frame by the owning player controller, which sends the packet: weapons are dormant most of the time, so they can't receive RPCs themselves.
+	 * @returns false if there's nothing to send this frame
+	 */
+	bool FlushFireCommands(FHoloFireCommandPacket& OutPacket);
+
+	/**
+	 * [Server] Processes a packet of fire commands received from the owning client. Commands are de-duplicated by sequence.
+	 * @param OutAck - Most recent command processed and outcome of the latest shots, to acknowledge back to the client
+	 * @returns false if no command has been processed yet
+	 */
+	bool Auth_ReceiveFireCommands(const FHoloFireCommandPacket& Packet, FHoloFireAck& OutAck);
+
+	/** [Client] Drops the pending commands the server has processed, and confirms or rolls back the hits we predicted for them. */
+	void AcknowledgeFireCommands(const FHoloFireAck& Ack);
+
+	/**
+	 * Restarts the stream of fire commands from scratch, on both ends: sequences, cooldowns, predictions and hit markers.
+	 * Called whenever the weapon's pawn gets a new controller, which may be another player's when the pawn is pooled.
+	 */
+	void ResetFireCommandStream();
+
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnHitFeedback, uint16 /*ShotSequence*/, EHoloHitFeedback /*Feedback*/);
+
+	/** Broadcast on the shooter's machine when one of its shots is predicted, confirmed or rolled back as a hit. */
+	FOnHitFeedback OnHitFeedbackDelegate;
+
+	DECLARE_MULTICAST_DELEGATE(FOnShotFired);
 
-	UFUNCTION(Server, Reliable)
-	void Server_TryFire(const FVector& MuzzleLocation, const FVector& Direction);
+	/** Broadcast on the shooter's machine for every shot it fires. */
+	FOnShotFired OnShotFiredDelegate;
+
+	//////////////////////////////////////////////////////////////////////////
+	// Projectiles
+	//////////////////////////////////////////////////////////////////////////
+
+	float GetProjectileSpeed() const { return ProjectileSpeed; }
+	float GetProjectileGravityScale() const { return ProjectileGravityScale; }
+	float GetProjectileLifetime() const { return ProjectileLifetime; }
+	float GetProjectileRadius() const { return ProjectileRadius; }
+	float GetProjectileSpread() const { return ProjectileSpread; }
+	UParticleSystem* GetProjectileTrailEffect() const { return ProjectileTrailEffect.Get(); }
+
+	/** Called by UHoloProjectileSubsystem when a projectile of this weapon hits something: deals damage if authoritative, and plays the impact. */
+	void OnProjectileImpact(const FHitResult& Hit, const FVector& Direction, bool bAuthoritative);
+
+	/** [Client] Launches the cosmetic copy of a projectile fired by another player. */
+	void OnProjectileSpawnReceived(const FHoloProjectileSpawn& Spawn);
+
+	/** Adds the effects and sounds of the weapon, which are soft references, to the list of assets to load. */
+	void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+
+	/**
+	 * Returns the latest hit marker to display, if it hasn't been rolled back.
+	 * @param OutAge - Seconds since the hit was first shown
+	 * @param bOutConfirmed - Whether the server confirmed the hit yet
+	 */
+	bool GetHitMarker(float& OutAge, bool& bOutConfirmed) const;
 	
 protected:
 
@@ -66,36 +233,88 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing")
 	float FireCooldown;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing")
+	EHoloFireMode FireMode;
+
+	/** Number of shots fired per trigger pull in Burst mode. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing", meta=(ClampMin=1, EditCondition="FireMode == EHoloFireMode::Burst"))
+	int32 BurstCount;
+
 	/** How much base damage does a weapon do */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing")
 	float BaseDamage;
 
+	/** How far the muzzle location sent by a client may be from the server's muzzle before the server's one is used instead. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing")
+	float MaxMuzzleLocationError;
+
+	/** Whether shots launch projectiles (simulated by UHoloProjectileSubsystem) rather than hitting instantly. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile")
+	bool bFiresProjectiles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile", meta=(EditCondition="bFiresProjectiles"))
+	float ProjectileSpeed;
+
+	/** Fraction of the world gravity applied to projectiles. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile", meta=(EditCondition="bFiresProjectiles"))
+	float ProjectileGravityScale;
+
+	/** Seconds after which projectiles that haven't hit anything disappear. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile", meta=(EditCondition="bFiresProjectiles"))
+	float ProjectileLifetime;
+
+	/** Radius of the sphere swept by projectiles. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile", meta=(EditCondition="bFiresProjectiles"))
+	float ProjectileRadius;
+
+	/** Half angle of the cone projectiles are randomly fired within, the same on every machine. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Projectile", meta=(EditCondition="bFiresProjectiles", Units="Degrees"))
+	float ProjectileSpread;
+
+	/** Whether shots explode where they hit, damaging every pawn around that isn't shielded by level geometry. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Explosion")
+	bool bExplodesOnImpact;
+
+	/** Damage and falloff of the explosions, on top of the damage dealt to what was directly hit. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Firing|Explosion", meta=(EditCondition="bExplodesOnImpact"))
+	FRadialDamageParams ExplosionDamage;
+
 	//////////////////////////////////////////////////////////////////////////
 	// VFX & SFX
 	//////////////////////////////////////////////////////////////////////////
 
+	// Effects are soft references, streamed in by UHoloAssetPreloadSubsystem: they're skipped until they're loaded.
+
 	/** Visual effect to play (at the muzzle) when the weapon is fired. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
-	UParticleSystem* FireEffect;
+	TSoftObjectPtr<UParticleSystem> FireEffect;
 
 	/** Particle system spawned when the weapon hits something (with +X oriented along the impact normal). */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
-	UParticleSystem* ImpactEffect;
+	TSoftObjectPtr<UParticleSystem> ImpactEffect;
 
 	/** Sound to play when the weapon is fired. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
-	USoundBase* FireSound;
+	TSoftObjectPtr<USoundBase> FireSound;
 
 	/** Sound to play when the weapon hits an actor and successfully deals damage. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
-	USoundBase* DamagingImpactSound;
+	TSoftObjectPtr<USoundBase> DamagingImpactSound;
 
 	/** Sound to play when the weapon hits an inert surface. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
-	USoundBase* NonDamagingImpactSound;
+	TSoftObjectPtr<USoundBase> NonDamagingImpactSound;
 
 	UPROPERTY(EditDefaultsOnly, Category=Effects)
-	TSubclassOf<UCameraShakeBase> FireCameraShake;
+	TSoftClassPtr<UCameraShakeBase> FireCameraShake;
+
+	/** Tracer following each projectile fired, moved along by UHoloProjectileSubsystem. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
+	TSoftObjectPtr<UParticleSystem> ProjectileTrailEffect;
+
+	/** Effect played in addition to ImpactEffect when shots explode. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Effects")
+	TSoftObjectPtr<UParticleSystem> ExplosionEffect;
 
 	//////////////////////////////////////////////////////////////////////////
 	// Aim
@@ -125,23 +344,129 @@ protected:
 	UPROPERTY(Transient, VisibleAnywhere, BlueprintReadOnly, Category="Aiming|State")
 	bool bAimLocationIsValid;
 
-	/** Checks if we can fire */
+	/** Checks if we can fire a shot that is due */
 	bool CanFire() const;
 
 private:
 
-	/** Replicated to non-owning clients: contains information about the last fire event that the server generated for this weapon. */
-	UPROPERTY(Transient, ReplicatedUsing=OnRep_HitNotify)
-	FInstantHitInfo HitNotify;
+	/**
+	 * Replicated to non-owning clients: contains the most recent fire events that the server generated for this weapon.
+	 * This is the only state of the weapon that changes during play, so the weapon stays dormant and is only woken up when an event is added.
+	 * Events that were already received before the weapon went dormant aren't played again: clients keep their copy of the log,
+	 * so events resent after a wake up are matched by ID, and the age check of OnHitEventReceived covers the rest.
+	 */
+	UPROPERTY(Transient, Replicated)
+	FHoloHitEventLog HitEvents;
+
+	/** Whether the trigger is held, for full automatic fire. */
+	bool bTriggerHeld;
+
+	/** Shots of the last trigger pulls that haven't been fired yet, for semi automatic and burst fire. */
+	int32 QueuedShots;
+
+	/** Game time when the next shot is due. */
+	float NextShotTime;
 
-	/** Game time when the weapon was last fired, for cooldown checks. */
-	float LastFireTime;
+	/** Fires a single shot, that was due at the given game time. */
+	void FireShot(float ShotTime);
+
+	/** Hands a projectile over to UHoloProjectileSubsystem, which also plays its tracer. */
+	void LaunchProjectile(const FHoloProjectileSpawn& Spawn, float LocalSpawnTime, bool bAuthoritative);
+
+	/** Queues the explosion of a shot that hit something, if this weapon's shots explode. Server/authority only. */
+	void Auth_Explode(const FVector& ImpactPoint, const FVector& ImpactNormal);
+
+	/** Index of this weapon in UHoloWeaponRotationSubsystem, INDEX_NONE if not registered. */
+	int32 RotationSlot;
+
+	//////////////////////////////////////////////////////////////////////////
+	// Fire commands stream
+	//////////////////////////////////////////////////////////////////////////
+
+	/** How often unacknowledged fire commands are sent again when no new shots are fired. */
+	UPROPERTY(EditDefaultsOnly, Category="Firing|Network")
+	float FireCommandResendInterval;
+
+	/** Fire commands older than this (in seconds) are dropped: by the client when resending, and by the server when receiving. */
+	UPROPERTY(EditDefaultsOnly, Category="Firing|Network")
+	float MaxFireCommandAge;
+
+	/** [Client] Commands the server hasn't acknowledged yet, oldest first. Never holds more than FHoloFireCommandPacket::MaxCommands entries. */
+	TArray<FHoloFireCommand, TInlineAllocator<FHoloFireCommandPacket::MaxCommands>> PendingFireCommands;
+
+	/** [Client] Sequence number that will be given to the next fire command. */
+	uint16 NextFireSequence;
+
+	/** [Client] Whether a command was added since the last flush. */
+	bool bHasNewFireCommands;
+
+	/** [Client] Game time when fire commands were last sent. */
+	float LastFireCommandsSendTime;
+
+	struct FPredictedShot
+	{
+		uint16 Sequence;
+		bool bPredictedDamage;
+	};
+
+	/** [Client] Shots waiting for their outcome from the server, oldest first. */
+	TArray<FPredictedShot, TInlineAllocator<FHoloFireAck::NumOutcomes>> PredictedShots;
+
+	/** Latest hit marker: shot it belongs to, game time it was first shown, and latest feedback. */
+	uint16 HitMarkerSequence;
+	float HitMarkerTime;
+	EHoloHitFeedback HitMarkerFeedback;
+
+	/** [Server] Sequence number of the most recent command processed. */
+	uint16 LastProcessedFireSequence;
+
+	/** [Server] Whether LastProcessedFireSequence is meaningful yet. */
+	bool bHasProcessedFireCommand;
+
+	/**
+	 * [Server] Earliest client fire time the next command may have. Advances by a full cooldown per accepted shot, so that
+	 * the jitter tolerance never adds up over consecutive shots.
+	 */
+	float NextClientFireTime;
+
+	/** [Server] Outcome of the most recent commands processed, see FHoloFireAck::DamageMask. */
+	uint16 ConfirmedDamageMask;
+
+	/**
+	 * [Server] Validates and executes a single shot.
+	 * @returns true if the shot caused damage
+	 */
+	bool Auth_ProcessFireCommand(const FHoloFireCommand& Command);
+
+	/** Updates the hit marker and broadcasts OnHitFeedbackDelegate. */
+	void NotifyHitFeedback(uint16 ShotSequence, EHoloHitFeedback Feedback);
+
+	/** Returns the server world time as seen by this machine. */
+	float GetServerWorldTime() const;
+
+	//////////////////////////////////////////////////////////////////////////
+	// Fire events replication
+	//////////////////////////////////////////////////////////////////////////
+
+	/** How many fire events HitEvents keeps: bounds the memory and bandwidth used by each weapon. */
+	UPROPERTY(EditDefaultsOnly, Category="Firing|Network", meta=(ClampMin=1))
+	int32 MaxHitEvents;
+
+	/** Fire events older than this (in seconds) are not played when received, e.g. when the weapon has just become relevant. */
+	UPROPERTY(EditDefaultsOnly, Category="Firing|Network")
+	float MaxHitEventAge;
 
 	// Effects
 	void PlayFireEffects() const;
 	void PlayImpactEffects(const FVector& ImpactPoint, const FVector& ImpactNormal, bool bCausedDamage);
-	bool RunFireTrace(FHitResult& OutHit);
+	bool RunFireTrace(const FVector& TraceStart, const FVector& Direction, FHitResult& OutHit) const;
+
+	/** Server version of RunFireTrace: targets are rewound to where they were on the client's screen when it fired. */
+	bool Auth_RunFireTrace(const FVector& TraceStart, const FVector& Direction, float ClientFireTime, FHitResult& OutHit) const;
+
+	/** Called on non-owning clients for each fire event received through HitEvents. */
+	void OnHitEventReceived(const FInstantHitInfo& HitInfo);
 
-	UFUNCTION()
-	void OnRep_HitNotify();
+	friend struct FInstantHitInfo;
+	friend class UHoloWeaponRotationSubsystem;
 };
@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/HoloTickableWorldSubsystem.h"
+#include "HoloWeaponRotationSubsystem.generated.h"
+
+class AHoloWeapon;
+
+/**
+ * Orients every weapon of the world toward what its owner is aiming at, in a single pass per frame.
+ * Weapons don't tick on their own: their aim state is pushed here and stored in contiguous arrays,
+ * rotations are interpolated in one vectorized loop, and only weapons whose rotation actually changed are moved.
+ */
+UCLASS()
+class HOLO_API UHoloWeaponRotationSubsystem : public UHoloTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+	void RegisterWeapon(AHoloWeapon* Weapon);
+	void UnregisterWeapon(AHoloWeapon* Weapon);
+
+	/** Updates the location the weapon should rotate toward. */
+	void SetAimTarget(const AHoloWeapon* Weapon, const FVector& AimLocation, bool bAimLocationIsValid);
+
+	/** Freezes or resumes the rotation updates of the weapon. */
+	void SetRotationEnabled(const AHoloWeapon* Weapon, bool bEnabled);
+
+private:
+
+	/** Registered weapons; every other array is indexed the same way. */
+	UPROPERTY(Transient)
+	TArray<AHoloWeapon*> Weapons;
+
+	TArray<FVector> AimLocations;
+	TArray<bool> AimLocationsValid;
+	TArray<bool> RotationsEnabled;
+	TArray<float> AimInterpSpeeds;
+	TArray<float> DropInterpSpeeds;
+
+	/** Local-space rotation adopted by each weapon when it's not aimed at a valid point. */
+	TArray<FQuat> DropRotations;
+
+	/** Per-frame scratch buffers, kept around to avoid reallocating them every frame. */
+	TArray<FQuat> CurrentRotations;
+	TArray<FQuat> TargetRotations;
+	TArray<FQuat> NewRotations;
+	TArray<float> InterpAlphas;
+};
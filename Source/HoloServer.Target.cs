@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class HoloServerTarget : TargetRules
+{
+	public HoloServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+		DefaultBuildSettings = BuildSettingsVersion.V2;
+		// Push model replication is compiled out of the installed engine's shared build environment
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+		bWithPushModel = true;
+
+		ExtraModuleNames.AddRange( new string[] { "Holo" } );
+	}
+}